@@ -0,0 +1,312 @@
+#include "CameleonCandidateSet.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "SceneView.h"
+
+// Number of the candidates scored by a single worker, a multiple of the vector width
+static constexpr int32 ScoringChunkSize = 64;
+
+void FCameleonCandidateSnapshot::Reset(const int32 ExpectedNum)
+{
+	LocationsX.Reset(ExpectedNum);
+	LocationsY.Reset(ExpectedNum);
+	LocationsZ.Reset(ExpectedNum);
+	MatchesQuery.Reset(ExpectedNum);
+}
+
+void FCameleonCandidateSnapshot::Add(const FVector& Location, const bool bMatchesQuery)
+{
+	LocationsX.Add(Location.X);
+	LocationsY.Add(Location.Y);
+	LocationsZ.Add(Location.Z);
+	MatchesQuery.Add(bMatchesQuery);
+}
+
+void FCameleonCandidateSnapshot::Score(const FCameleonScoringView& View,
+                                       const FCameleonCandidateScoring& Scoring,
+                                       const int32 MinParallelCandidates,
+                                       TArray<float>& OutScores) const
+{
+	const int32 numCandidates = Num();
+	OutScores.SetNumUninitialized(numCandidates);
+
+	// Every chunk writes only its own scores
+	const int32 numChunks = FMath::DivideAndRoundUp(numCandidates, ScoringChunkSize);
+	ParallelFor(numChunks, [&](const int32 ChunkIdx)
+	{
+		const int32 first = ChunkIdx * ScoringChunkSize;
+		ScoreRange(first, FMath::Min(first + ScoringChunkSize, numCandidates), View, Scoring, OutScores);
+	}, numCandidates < MinParallelCandidates);
+}
+
+void FCameleonCandidateSnapshot::ScoreRange(const int32 First,
+                                            const int32 Last,
+                                            const FCameleonScoringView& View,
+                                            const FCameleonCandidateScoring& Scoring,
+                                            TArray<float>& OutScores) const
+{
+	const auto playerX = VectorSetFloat1(View.PlayerLocation.X);
+	const auto playerY = VectorSetFloat1(View.PlayerLocation.Y);
+	const auto playerZ = VectorSetFloat1(View.PlayerLocation.Z);
+
+	const auto cameraX = VectorSetFloat1(View.CameraLocation.X);
+	const auto cameraY = VectorSetFloat1(View.CameraLocation.Y);
+	const auto cameraZ = VectorSetFloat1(View.CameraLocation.Z);
+
+	const auto forwardX = VectorSetFloat1(View.CameraForward.X);
+	const auto forwardY = VectorSetFloat1(View.CameraForward.Y);
+	const auto forwardZ = VectorSetFloat1(View.CameraForward.Z);
+
+	// Keeps the zero length vectors at zero distance and a right angle like FVector::GetSafeNormal() does
+	const auto minLengthSquared = VectorSetFloat1(SMALL_NUMBER);
+
+	const auto screenCenter = View.ViewportSize * 0.5f;
+	const float maxScreenOffset = View.ViewportSize.Size();
+
+	float distances[4];
+	float dots[4];
+
+	for (int32 groupIdx = First; groupIdx < Last; groupIdx += 4)
+	{
+		const int32 groupSize = FMath::Min(4, Last - groupIdx);
+
+		// Distances to the player and the dot products of the camera's forward vector and the directions
+		// to the candidates, four at once while there are enough of them
+
+		if (groupSize == 4)
+		{
+			const auto locationX = VectorLoad(&LocationsX[groupIdx]);
+			const auto locationY = VectorLoad(&LocationsY[groupIdx]);
+			const auto locationZ = VectorLoad(&LocationsZ[groupIdx]);
+
+			const auto toPlayerX = VectorSubtract(locationX, playerX);
+			const auto toPlayerY = VectorSubtract(locationY, playerY);
+			const auto toPlayerZ = VectorSubtract(locationZ, playerZ);
+
+			auto playerLengthSquared = VectorMultiply(toPlayerX, toPlayerX);
+			playerLengthSquared = VectorMultiplyAdd(toPlayerY, toPlayerY, playerLengthSquared);
+			playerLengthSquared = VectorMultiplyAdd(toPlayerZ, toPlayerZ, playerLengthSquared);
+
+			VectorStore(VectorMultiply(playerLengthSquared,
+			                           VectorReciprocalSqrtAccurate(VectorMax(playerLengthSquared, minLengthSquared))),
+			            distances);
+
+			const auto toCameraX = VectorSubtract(locationX, cameraX);
+			const auto toCameraY = VectorSubtract(locationY, cameraY);
+			const auto toCameraZ = VectorSubtract(locationZ, cameraZ);
+
+			auto cameraLengthSquared = VectorMultiply(toCameraX, toCameraX);
+			cameraLengthSquared = VectorMultiplyAdd(toCameraY, toCameraY, cameraLengthSquared);
+			cameraLengthSquared = VectorMultiplyAdd(toCameraZ, toCameraZ, cameraLengthSquared);
+
+			auto facingDots = VectorMultiply(toCameraX, forwardX);
+			facingDots = VectorMultiplyAdd(toCameraY, forwardY, facingDots);
+			facingDots = VectorMultiplyAdd(toCameraZ, forwardZ, facingDots);
+
+			VectorStore(VectorMultiply(facingDots,
+			                           VectorReciprocalSqrtAccurate(VectorMax(cameraLengthSquared, minLengthSquared))),
+			            dots);
+		}
+		else
+		{
+			for (int32 lane = 0; lane < groupSize; ++lane)
+			{
+				const FVector location(LocationsX[groupIdx + lane], LocationsY[groupIdx + lane], LocationsZ[groupIdx + lane]);
+				distances[lane] = (location - View.PlayerLocation).Size();
+				dots[lane] = FVector::DotProduct(View.CameraForward, (location - View.CameraLocation).GetSafeNormal());
+			}
+		}
+
+		// The rest of the terms don't vectorize
+
+		for (int32 lane = 0; lane < groupSize; ++lane)
+		{
+			const int32 candidateIdx = groupIdx + lane;
+			float score = 0.f;
+
+			if (Scoring.DistanceWeight != 0.f)
+			{
+				score += Scoring.DistanceWeight * distances[lane];
+			}
+
+			if (Scoring.FacingAngleWeight != 0.f)
+			{
+				score += Scoring.FacingAngleWeight * FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(dots[lane], -1.f, 1.f)));
+			}
+
+			if (Scoring.ScreenOffsetWeight != 0.f)
+			{
+				const FVector location(LocationsX[candidateIdx], LocationsY[candidateIdx], LocationsZ[candidateIdx]);
+
+				FVector2D screenLocation;
+				if (View.bHasProjection &&
+					FSceneView::ProjectWorldToScreen(location, View.ViewRect, View.ViewProjectionMatrix, screenLocation))
+				{
+					score += Scoring.ScreenOffsetWeight * FVector2D::Distance(screenLocation, screenCenter);
+				}
+				else
+				{
+					// Behind the camera, as far from the center as it gets
+					score += Scoring.ScreenOffsetWeight * maxScreenOffset;
+				}
+			}
+
+			OutScores[candidateIdx] = MatchesQuery[candidateIdx] ? score : MAX_flt;
+		}
+	}
+}
+
+FCameleonCandidateHandle FCameleonCandidateSet::Add(ACameleonGameCharacter* Character,
+                                                    AControllableCharacterMarker* Marker,
+                                                    const float Score)
+{
+	// Grab a free slot so the handle stays valid no matter how the candidates get reordered
+
+	int32 slot;
+	if (FreeSlots.Num() > 0)
+	{
+		slot = FreeSlots.Pop(false);
+	}
+	else
+	{
+		slot = SlotIndices.Add(INDEX_NONE);
+		SlotSerials.Add(0);
+	}
+
+	FCameleonCandidateHandle handle;
+	handle.Slot = slot;
+	handle.Serial = ++SlotSerials[slot];
+
+	// Find the place for the candidate, the ones with the same score keep their order
+
+	int32 candidateIndex = Candidates.Num();
+	while (candidateIndex > 0 && Candidates[candidateIndex - 1].Score > Score)
+	{
+		--candidateIndex;
+	}
+
+	FCameleonCandidate candidate;
+	candidate.Character = Character;
+	candidate.Marker = Marker;
+	candidate.Score = Score;
+	candidate.Handle = handle;
+
+	Candidates.Insert(candidate, candidateIndex);
+	UpdateSlotIndices(candidateIndex, Candidates.Num() - 1);
+
+	CharacterSlots.Add(Character, slot);
+
+	if (!ActiveHandle.IsValid())
+	{
+		ActiveHandle = handle;
+	}
+
+	return handle;
+}
+
+bool FCameleonCandidateSet::Remove(const ACameleonGameCharacter* Character)
+{
+	int32 slot;
+	if (!CharacterSlots.RemoveAndCopyValue(Character, slot))
+	{
+		return false;
+	}
+
+	const int32 removedIndex = SlotIndices[slot];
+	const bool bWasActive = ActiveHandle == Candidates[removedIndex].Handle;
+
+	Candidates.RemoveAt(removedIndex, 1, false);
+	UpdateSlotIndices(removedIndex, Candidates.Num() - 1);
+
+	SlotIndices[slot] = INDEX_NONE;
+	FreeSlots.Add(slot);
+
+	// The candidate that took the place of the removed one becomes active,
+	// or the last one if we've removed the last candidate
+
+	if (bWasActive)
+	{
+		SetActiveIndex(FMath::Min(removedIndex, Candidates.Num() - 1));
+	}
+
+	return true;
+}
+
+void FCameleonCandidateSet::Empty()
+{
+	Candidates.Reset();
+	SlotIndices.Reset();
+	SlotSerials.Reset();
+	FreeSlots.Reset();
+	CharacterSlots.Reset();
+	ActiveHandle = FCameleonCandidateHandle();
+}
+
+bool FCameleonCandidateSet::Rank()
+{
+	const int32 numCandidates = Candidates.Num();
+	if (numCandidates < 2)
+	{
+		return false;
+	}
+
+	// The scores change only a bit from one frame to another so the candidates are almost sorted already,
+	// which insertion sort handles in linear time. If it turns out to be doing more work than a regular
+	// sort would, we give up on it and sort everything at once
+
+	const int32 maxMoves = numCandidates * FMath::Max(1u, FMath::CeilLogTwo(numCandidates));
+	int32 numMoves = 0;
+	int32 firstMoved = numCandidates;
+
+	for (int32 candidateIdx = 1; candidateIdx < numCandidates && numMoves <= maxMoves; ++candidateIdx)
+	{
+		int32 insertIdx = candidateIdx;
+		while (insertIdx > 0 && Candidates[insertIdx - 1].Score > Candidates[insertIdx].Score)
+		{
+			Candidates.Swap(insertIdx - 1, insertIdx);
+			--insertIdx;
+			++numMoves;
+		}
+
+		firstMoved = FMath::Min(firstMoved, insertIdx);
+	}
+
+	if (numMoves > maxMoves)
+	{
+		Algo::StableSortBy(Candidates, &FCameleonCandidate::Score);
+		firstMoved = 0;
+	}
+
+	if (numMoves == 0)
+	{
+		return false;
+	}
+
+	UpdateSlotIndices(firstMoved, numCandidates - 1);
+	return true;
+}
+
+const FCameleonCandidate* FCameleonCandidateSet::Find(const ACameleonGameCharacter* Character) const
+{
+	const auto slot = CharacterSlots.Find(Character);
+	return slot ? &Candidates[SlotIndices[*slot]] : nullptr;
+}
+
+int32 FCameleonCandidateSet::IndexOf(const FCameleonCandidateHandle& Handle) const
+{
+	if (!SlotIndices.IsValidIndex(Handle.Slot) || SlotSerials[Handle.Slot] != Handle.Serial)
+	{
+		return INDEX_NONE;
+	}
+
+	return SlotIndices[Handle.Slot];
+}
+
+void FCameleonCandidateSet::UpdateSlotIndices(const int32 FirstIndex, const int32 LastIndex)
+{
+	for (int32 candidateIdx = FirstIndex; candidateIdx <= LastIndex; ++candidateIdx)
+	{
+		SlotIndices[Candidates[candidateIdx].Handle.Slot] = candidateIdx;
+	}
+}
@@ -0,0 +1,235 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CameleonCandidateSet.generated.h"
+
+class ACameleonGameCharacter;
+class AControllableCharacterMarker;
+class UCameraComponent;
+
+// Weights of the terms making up a candidate's score, the candidate with the lowest score is ranked first //
+USTRUCT()
+struct FCameleonCandidateScoring
+{
+	GENERATED_BODY()
+
+	// Weight of the distance between the player and the candidate, in cm //
+	UPROPERTY(EditDefaultsOnly)
+	float DistanceWeight = 1.f;
+
+	// Weight of the angle between the camera's forward vector and the direction towards the candidate, in degrees //
+	UPROPERTY(EditDefaultsOnly)
+	float FacingAngleWeight = 0.f;
+
+	// Weight of the distance between the candidate's on-screen position and the center of the screen, in pixels //
+	UPROPERTY(EditDefaultsOnly)
+	float ScreenOffsetWeight = 0.f;
+};
+
+// What the scoring needs to know about the player's view, gathered on the game thread //
+struct FCameleonScoringView
+{
+	FVector PlayerLocation = FVector::ZeroVector;
+
+	FVector CameraLocation = FVector::ZeroVector;
+
+	FVector CameraForward = FVector::ForwardVector;
+
+	// Projection of the player's view, without it every candidate is as far from the center of the screen as it gets //
+
+	bool bHasProjection = false;
+
+	FMatrix ViewProjectionMatrix = FMatrix::Identity;
+
+	FIntRect ViewRect;
+
+	FVector2D ViewportSize = FVector2D::ZeroVector;
+};
+
+// Read-only copy of the candidates' state taken on the game thread, so that they can be scored on the workers //
+struct CAMELEONGAME_API FCameleonCandidateSnapshot
+{
+	void Reset(int32 ExpectedNum);
+
+	void Add(const FVector& Location, bool bMatchesQuery);
+
+	int32 Num() const
+	{
+		return LocationsX.Num();
+	}
+
+	// Scores every candidate the same way USwitchCharacterComponent::ScoreCandidate() does, the candidates //
+	// which don't match the query anymore are ranked last. Chunks of the candidates are scored in parallel //
+	// once there are at least MinParallelCandidates of them //
+	void Score(const FCameleonScoringView& View,
+	           const FCameleonCandidateScoring& Scoring,
+	           int32 MinParallelCandidates,
+	           TArray<float>& OutScores) const;
+
+private:
+	void ScoreRange(int32 First,
+	                int32 Last,
+	                const FCameleonScoringView& View,
+	                const FCameleonCandidateScoring& Scoring,
+	                TArray<float>& OutScores) const;
+
+	TArray<float> LocationsX;
+	TArray<float> LocationsY;
+	TArray<float> LocationsZ;
+
+	TArray<bool> MatchesQuery;
+};
+
+// Stable reference to a candidate which survives re-ranks and removal of other candidates //
+struct FCameleonCandidateHandle
+{
+	int32 Slot = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const
+	{
+		return Slot != INDEX_NONE;
+	}
+
+	bool operator==(const FCameleonCandidateHandle& Other) const
+	{
+		return Slot == Other.Slot && Serial == Other.Serial;
+	}
+
+	bool operator!=(const FCameleonCandidateHandle& Other) const
+	{
+		return !(*this == Other);
+	}
+};
+
+USTRUCT()
+struct FCameleonCandidate
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	ACameleonGameCharacter* Character = nullptr;
+
+	// Marker shown above the character, null when the markers are instanced //
+	UPROPERTY()
+	AControllableCharacterMarker* Marker = nullptr;
+
+	// Camera we blend to when switching to the character, looked up once when the candidate is added //
+	UPROPERTY()
+	UCameraComponent* Camera = nullptr;
+
+	float Score = 0.f;
+
+	FCameleonCandidateHandle Handle;
+
+	// Snapshot of the background validation: the character was in front of the player and nothing was blocking it //
+
+	bool bSwitchEligible = false;
+
+	// Time of the last validation, negative if the candidate hasn't been validated yet //
+	float SwitchValidationTime = -1.f;
+
+	bool bSwitchValidationInFlight = false;
+};
+
+// Characters in the player's sight that can be taken control over, kept densely in the order of their score //
+// along with the one that's currently active //
+USTRUCT()
+struct CAMELEONGAME_API FCameleonCandidateSet
+{
+	GENERATED_BODY()
+
+public:
+	// Inserts the candidate at the place matching its score, it becomes active if there was no active one //
+	FCameleonCandidateHandle Add(ACameleonGameCharacter* Character, AControllableCharacterMarker* Marker, float Score);
+
+	// Removes the candidate, if it was active the next one in order becomes active //
+	bool Remove(const ACameleonGameCharacter* Character);
+
+	void Empty();
+
+	// Re-sorts the candidates by their current scores, returns true if the order has changed //
+	bool Rank();
+
+	int32 Num() const
+	{
+		return Candidates.Num();
+	}
+
+	FCameleonCandidate& operator[](const int32 Index)
+	{
+		return Candidates[Index];
+	}
+
+	const FCameleonCandidate& operator[](const int32 Index) const
+	{
+		return Candidates[Index];
+	}
+
+	const FCameleonCandidate* Find(const ACameleonGameCharacter* Character) const;
+
+	bool Contains(const ACameleonGameCharacter* Character) const
+	{
+		return CharacterSlots.Contains(Character);
+	}
+
+	// Index of the candidate in the current order, INDEX_NONE if the handle is stale //
+	int32 IndexOf(const FCameleonCandidateHandle& Handle) const;
+
+	int32 GetActiveIndex() const
+	{
+		return IndexOf(ActiveHandle);
+	}
+
+	const FCameleonCandidate* GetActive() const
+	{
+		const int32 activeIndex = GetActiveIndex();
+		return activeIndex != INDEX_NONE ? &Candidates[activeIndex] : nullptr;
+	}
+
+	void SetActiveIndex(const int32 Index)
+	{
+		ActiveHandle = Candidates.IsValidIndex(Index) ? Candidates[Index].Handle : FCameleonCandidateHandle();
+	}
+
+	TArray<FCameleonCandidate>::RangedForIteratorType begin()
+	{
+		return Candidates.begin();
+	}
+
+	TArray<FCameleonCandidate>::RangedForIteratorType end()
+	{
+		return Candidates.end();
+	}
+
+	TArray<FCameleonCandidate>::RangedForConstIteratorType begin() const
+	{
+		return Candidates.begin();
+	}
+
+	TArray<FCameleonCandidate>::RangedForConstIteratorType end() const
+	{
+		return Candidates.end();
+	}
+
+private:
+	// Points the slots of the candidates in the given range at their current indices //
+	void UpdateSlotIndices(int32 FirstIndex, int32 LastIndex);
+
+	// Candidates ordered by their score //
+	UPROPERTY()
+	TArray<FCameleonCandidate> Candidates;
+
+	// Index of the candidate occupying the slot, INDEX_NONE for free slots //
+	TArray<int32> SlotIndices;
+
+	TArray<uint32> SlotSerials;
+
+	TArray<int32> FreeSlots;
+
+	TMap<const ACameleonGameCharacter*, int32> CharacterSlots;
+
+	FCameleonCandidateHandle ActiveHandle;
+};
@@ -0,0 +1,239 @@
+#include "CameleonCrowdAnimationSubsystem.h"
+#include "CameleonGameCharacter.h"
+#include "CameleonProfiling.h"
+#include "SwitchCharacterComponent.h"
+#include "Animation/AnimationAsset.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "IAnimationBudgetAllocator.h"
+#include "SkeletalMeshComponentBudgeted.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Animation"), STAT_Cameleon_CrowdAnimation, STATGROUP_Cameleon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Shared Pose Followers"), STAT_Cameleon_SharedPoseFollowers, STATGROUP_Cameleon);
+
+void UCameleonCrowdAnimationSubsystem::Deinitialize()
+{
+	Characters.Empty();
+	PoseLeaders.Empty();
+	PoseLeaderActors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCameleonCrowdAnimationSubsystem::RegisterCharacter(ACameleonGameCharacter* Character)
+{
+	if (Character && Character->GetMesh())
+	{
+		Characters.AddUnique(Character);
+	}
+}
+
+void UCameleonCrowdAnimationSubsystem::UnregisterCharacter(ACameleonGameCharacter* Character)
+{
+	if (Characters.RemoveSingleSwap(Character, false) > 0)
+	{
+		SetPoseLeader(Character, nullptr);
+	}
+}
+
+void UCameleonCrowdAnimationSubsystem::Tick(const float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		TimeSinceUpdate = 0.f;
+		UpdateCrowdAnimation();
+	}
+}
+
+void UCameleonCrowdAnimationSubsystem::UpdateCrowdAnimation()
+{
+	SCOPE_CYCLE_COUNTER(STAT_Cameleon_CrowdAnimation);
+
+	const auto world = GetWorld();
+
+	// The players' characters, the characters we're switching to and the active switch targets
+	// animate at the full rate
+
+	TArray<const AActor*, TInlineAllocator<8>> fullRateActors;
+	ViewerLocations.Reset();
+
+	for (auto playerControllerIt = world->GetPlayerControllerIterator(); playerControllerIt; ++playerControllerIt)
+	{
+		const auto playerController = playerControllerIt->Get();
+		if (!playerController)
+		{
+			continue;
+		}
+
+		if (const auto viewTarget = playerController->GetViewTarget())
+		{
+			ViewerLocations.Add(viewTarget->GetActorLocation());
+			fullRateActors.Add(viewTarget);
+		}
+
+		fullRateActors.Add(playerController->GetPawn());
+
+		if (const auto switchComponent = playerController->FindComponentByClass<USwitchCharacterComponent>())
+		{
+			fullRateActors.Add(switchComponent->GetActiveCandidateCharacter());
+		}
+	}
+
+	auto budgetAllocator = IAnimationBudgetAllocator::Get(world);
+	const float minSharedPoseDistanceSquared = FMath::Square(MinSharedPoseDistance);
+	int32 numFollowers = 0;
+
+	for (auto character : Characters)
+	{
+		auto mesh = character->GetMesh();
+		const bool bFullRate = fullRateActors.Contains(character);
+
+		float distanceSquared = MAX_flt;
+		for (const auto& viewerLocation : ViewerLocations)
+		{
+			distanceSquared = FMath::Min(distanceSquared, FVector::DistSquared(character->GetActorLocation(), viewerLocation));
+		}
+
+		// The update rate optimizations take care of the distance when the budget allocator is disabled
+		mesh->bEnableUpdateRateOptimizations = !bFullRate;
+
+		if (auto budgetedMesh = Cast<USkeletalMeshComponentBudgeted>(mesh))
+		{
+			float significance = 1.f;
+
+			if (!bFullRate)
+			{
+				significance = SignificanceDistance / FMath::Max(SignificanceDistance, FMath::Sqrt(distanceSquared));
+
+				if (!mesh->WasRecentlyRendered(0.2f))
+				{
+					significance *= NotRenderedSignificanceScale;
+				}
+			}
+
+			if (budgetAllocator && budgetedMesh->GetAnimationBudgetHandle() != INDEX_NONE)
+			{
+				budgetAllocator->SetComponentSignificance(budgetedMesh, significance, bFullRate, bFullRate);
+			}
+		}
+
+		// Characters standing still further away copy the pose of the leader instead of evaluating their own
+
+		USkeletalMeshComponent* leader = nullptr;
+
+		if (bSharePoses &&
+			!bFullRate &&
+			character->CrowdPose != ECameleonCrowdPose::None &&
+			distanceSquared >= minSharedPoseDistanceSquared &&
+			character->GetVelocity().IsNearlyZero())
+		{
+			leader = FindOrAddPoseLeader(character->CrowdPose, mesh);
+		}
+
+		SetPoseLeader(character, leader);
+		numFollowers += leader ? 1 : 0;
+	}
+
+	SET_DWORD_STAT(STAT_Cameleon_SharedPoseFollowers, numFollowers);
+}
+
+void UCameleonCrowdAnimationSubsystem::SetPoseLeader(ACameleonGameCharacter* Character,
+                                                     USkeletalMeshComponent* Leader) const
+{
+	auto mesh = Character->GetMesh();
+	if (mesh && mesh->MasterPoseComponent.Get() != Leader)
+	{
+		mesh->SetMasterPoseComponent(Leader);
+	}
+}
+
+USkeletalMeshComponent* UCameleonCrowdAnimationSubsystem::FindOrAddPoseLeader(const ECameleonCrowdPose Pose,
+                                                                              const USkeletalMeshComponent* Follower)
+{
+	USkeletalMesh* skeletalMesh = Follower->SkeletalMesh;
+	if (!skeletalMesh)
+	{
+		return nullptr;
+	}
+
+	const auto key = MakeTuple(Pose, skeletalMesh);
+	if (const auto leader = PoseLeaders.FindRef(key))
+	{
+		return leader;
+	}
+
+	// The idle leader runs the followers' animation blueprint, which stays idle as it doesn't move,
+	// the other poses play their animation
+
+	UAnimationAsset* animation = nullptr;
+
+	if (Pose == ECameleonCrowdPose::Selfie)
+	{
+		animation = SelfiePoseAnimation.LoadSynchronous();
+		if (!animation)
+		{
+			return nullptr;
+		}
+	}
+	else if (!Follower->AnimClass)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.ObjectFlags |= RF_Transient;
+
+	auto leaderActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, spawnParameters);
+	if (!leaderActor)
+	{
+		return nullptr;
+	}
+
+	auto leader = NewObject<USkeletalMeshComponent>(leaderActor, TEXT("PoseLeader"));
+	leader->SetSkeletalMesh(skeletalMesh);
+	leader->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	leader->SetHiddenInGame(true);
+
+	// The leader is never rendered, but the followers are
+	leader->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	leaderActor->SetRootComponent(leader);
+	leader->RegisterComponent();
+
+	if (animation)
+	{
+		leader->PlayAnimation(animation, true);
+	}
+	else
+	{
+		leader->SetAnimInstanceClass(Follower->AnimClass);
+	}
+
+	PoseLeaderActors.Add(leaderActor);
+	PoseLeaders.Add(key, leader);
+
+	return leader;
+}
+
+bool UCameleonCrowdAnimationSubsystem::IsTickable() const
+{
+	return Characters.Num() > 0;
+}
+
+ETickableTickType UCameleonCrowdAnimationSubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonCrowdAnimationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonCrowdAnimationSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonCrowdAnimationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
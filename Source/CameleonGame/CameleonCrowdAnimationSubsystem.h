@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CameleonCrowdAnimationSubsystem.generated.h"
+
+class ACameleonGameCharacter;
+class USkeletalMesh;
+class USkeletalMeshComponent;
+class UAnimationAsset;
+
+// Pose of a character standing still which can be shared with the other characters in the same pose //
+UENUM(BlueprintType)
+enum class ECameleonCrowdPose : uint8
+{
+	// The character always evaluates its own pose //
+	None,
+	// Standing idle //
+	Idle,
+	// Taking a selfie //
+	Selfie
+};
+
+// Keeps the animation of the unpossessed characters cheap: their significance for the animation budget allocator //
+// and the update rate optimizations are driven by the distance and visibility, the idle characters copy the pose //
+// of a shared leader instead of evaluating their own. The possessed character and the active switch target always //
+// animate at the full rate //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonCrowdAnimationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(ACameleonGameCharacter* Character);
+	void UnregisterCharacter(ACameleonGameCharacter* Character);
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	void UpdateCrowdAnimation();
+
+	// Sets the leader whose pose the character copies, nullptr to evaluate its own pose again //
+	void SetPoseLeader(ACameleonGameCharacter* Character, USkeletalMeshComponent* Leader) const;
+
+	// Returns the leader animating the pose for the characters with the mesh, spawns it on the first use //
+	USkeletalMeshComponent* FindOrAddPoseLeader(ECameleonCrowdPose Pose, const USkeletalMeshComponent* Follower);
+
+	// Characters up to this distance from a player's view target are the most significant for the budget allocator //
+	UPROPERTY(Config)
+	float SignificanceDistance = 1500.f;
+
+	// Significance multiplier of the characters which haven't been rendered recently //
+	UPROPERTY(Config)
+	float NotRenderedSignificanceScale = 0.25f;
+
+	// Should the idle characters share the poses of the leaders //
+	UPROPERTY(Config)
+	bool bSharePoses = true;
+
+	// Characters closer than this to a player's view target always evaluate their own pose //
+	UPROPERTY(Config)
+	float MinSharedPoseDistance = 1000.f;
+
+	// Animation played by the leader of the characters taking a selfie, no sharing for them if it's not set //
+	UPROPERTY(Config)
+	TSoftObjectPtr<UAnimationAsset> SelfiePoseAnimation;
+
+	// Seconds between the updates of the significance and the shared poses //
+	UPROPERTY(Config)
+	float UpdateInterval = 0.2f;
+
+	UPROPERTY()
+	TArray<ACameleonGameCharacter*> Characters;
+
+	// Hidden actors animating the shared poses //
+	UPROPERTY()
+	TArray<AActor*> PoseLeaderActors;
+
+	TMap<TPair<ECameleonCrowdPose, USkeletalMesh*>, USkeletalMeshComponent*> PoseLeaders;
+
+	// Scratch buffer for the locations of the players' view targets //
+	TArray<FVector> ViewerLocations;
+
+	float TimeSinceUpdate = 0.f;
+};
@@ -0,0 +1,374 @@
+#include "CameleonCrowdSubsystem.h"
+#include "CameleonGameCharacter.h"
+#include "CameleonProfiling.h"
+#include "SwitchCharacterComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd"), STAT_Cameleon_Crowd, STATGROUP_Cameleon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Records"), STAT_Cameleon_CrowdRecords, STATGROUP_Cameleon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Hydrated Crowd Characters"), STAT_Cameleon_HydratedCrowdCharacters,
+                               STATGROUP_Cameleon);
+
+void UCameleonCrowdSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	RecordGrid.SetCellSize(RecordGridCellSize);
+}
+
+void UCameleonCrowdSubsystem::Deinitialize()
+{
+	Records.Empty();
+	Archetypes.Empty();
+	RecordGrid.Reset();
+	HydratedRecords.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UCameleonCrowdSubsystem::IsCrowdEnabled() const
+{
+	const auto world = GetWorld();
+	return bEnableCrowd && world && world->IsGameWorld() && world->GetNetMode() != NM_Client;
+}
+
+void UCameleonCrowdSubsystem::RegisterCharacter(ACameleonGameCharacter* Character)
+{
+	// The characters spawned for a record are registered already
+	if (!Character || Character->CrowdRecordIndex != INDEX_NONE || !IsCrowdEnabled())
+	{
+		return;
+	}
+
+	// The character stays hydrated, it's dehydrated by the update if no player is close enough
+
+	const int32 recordIndex = Records.Num();
+
+	auto& record = Records.AddDefaulted_GetRef();
+	record.Location = Character->GetActorLocation();
+	record.Yaw = Character->GetActorRotation().Yaw;
+	record.Tags = Character->GetGameplayTags();
+	record.ArchetypeIndex = FindOrAddArchetype(Character->GetClass());
+	record.Pose = Character->CrowdPose;
+	record.Character = Character;
+
+	RecordGrid.Add(recordIndex, record.Location);
+	HydratedRecords.Add(recordIndex);
+	Character->CrowdRecordIndex = recordIndex;
+}
+
+void UCameleonCrowdSubsystem::UnregisterCharacter(ACameleonGameCharacter* Character)
+{
+	const int32 recordIndex = Character->CrowdRecordIndex;
+	if (recordIndex != INDEX_NONE)
+	{
+		Character->CrowdRecordIndex = INDEX_NONE;
+
+		if (Records.IsValidIndex(recordIndex) && Records[recordIndex].Character == Character)
+		{
+			RemoveRecord(recordIndex);
+		}
+
+		return;
+	}
+
+	for (auto& archetype : Archetypes)
+	{
+		if (archetype.FreeCharacters.RemoveSingleSwap(Character, false) > 0)
+		{
+			return;
+		}
+	}
+}
+
+void UCameleonCrowdSubsystem::Tick(const float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		TimeSinceUpdate = 0.f;
+		UpdateCrowd();
+	}
+}
+
+void UCameleonCrowdSubsystem::UpdateCrowd()
+{
+	SCOPE_CYCLE_COUNTER(STAT_Cameleon_Crowd);
+
+	const auto world = GetWorld();
+
+	// Gather the players' view targets, during a transition that's the character we're switching to, along with
+	// how far their scan volumes reach. The scan volume is placed in front of the camera, its far corner is
+	// the furthest it gets
+
+	TArray<const ACameleonGameCharacter*, TInlineAllocator<4>> activeCandidates;
+	ViewerLocations.Reset();
+	ViewerReaches.Reset();
+
+	for (auto playerControllerIt = world->GetPlayerControllerIterator(); playerControllerIt; ++playerControllerIt)
+	{
+		const auto playerController = playerControllerIt->Get();
+		const auto viewTarget = playerController ? playerController->GetViewTarget() : nullptr;
+		if (!viewTarget)
+		{
+			continue;
+		}
+
+		float reach = HydrationMargin;
+
+		if (const auto switchComponent = playerController->FindComponentByClass<USwitchCharacterComponent>())
+		{
+			const auto& scanDistance = switchComponent->GetScanDistance();
+			reach += FVector(scanDistance.X * 1.5f, scanDistance.Y, scanDistance.Z).Size();
+
+			activeCandidates.Add(switchComponent->GetActiveCandidateCharacter());
+		}
+
+		ViewerLocations.Add(viewTarget->GetActorLocation());
+		ViewerReaches.Add(reach);
+	}
+
+	// Dehydrate the characters which have left the reach of every player, the players' ones, the ones we're
+	// about to switch to and the ones still moving stay around. The placed characters are possessed by an AI
+	// controller, which doesn't keep them around
+
+	for (int32 hydratedIdx = HydratedRecords.Num() - 1; hydratedIdx >= 0; --hydratedIdx)
+	{
+		const int32 recordIndex = HydratedRecords[hydratedIdx];
+		const auto character = Records[recordIndex].Character;
+
+		if (character->IsPlayerControlled() || activeCandidates.Contains(character))
+		{
+			continue;
+		}
+
+		const auto movement = character->GetCharacterMovement();
+		if (!movement->IsMovingOnGround() || !movement->Velocity.IsNearlyZero() || character->HasAnyRootMotion())
+		{
+			continue;
+		}
+
+		const auto location = character->GetActorLocation();
+
+		bool bWithinReach = false;
+		for (int32 viewerIdx = 0; !bWithinReach && viewerIdx < ViewerLocations.Num(); ++viewerIdx)
+		{
+			const float dehydrationDistance = ViewerReaches[viewerIdx] + DehydrationHysteresis;
+			bWithinReach = FVector::DistSquared(location, ViewerLocations[viewerIdx]) <=
+				FMath::Square(dehydrationDistance);
+		}
+
+		if (!bWithinReach)
+		{
+			DehydrateRecord(recordIndex);
+		}
+	}
+
+	// Hydrate the records within the reach of the players, the grid narrows them down to the cells around
+
+	int32 numHydrations = 0;
+
+	for (int32 viewerIdx = 0; viewerIdx < ViewerLocations.Num() && numHydrations < MaxHydrationsPerUpdate; ++viewerIdx)
+	{
+		const auto& viewerLocation = ViewerLocations[viewerIdx];
+		const float reach = ViewerReaches[viewerIdx];
+
+		NearbyRecords.Reset();
+		RecordGrid.QueryBounds(FBox::BuildAABB(viewerLocation, FVector(reach)), NearbyRecords);
+
+		for (int32 nearbyIdx = 0; nearbyIdx < NearbyRecords.Num() && numHydrations < MaxHydrationsPerUpdate; ++nearbyIdx)
+		{
+			const int32 recordIndex = NearbyRecords[nearbyIdx];
+			const auto& record = Records[recordIndex];
+
+			if (!record.Character && FVector::DistSquared(record.Location, viewerLocation) <= FMath::Square(reach))
+			{
+				HydrateRecord(recordIndex);
+				++numHydrations;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_Cameleon_CrowdRecords, Records.Num());
+	SET_DWORD_STAT(STAT_Cameleon_HydratedCrowdCharacters, HydratedRecords.Num());
+	CSV_CUSTOM_STAT(Cameleon, HydratedCrowdCharacters, HydratedRecords.Num(), ECsvCustomStatOp::Set);
+}
+
+void UCameleonCrowdSubsystem::HydrateRecord(const int32 RecordIndex)
+{
+	if (const auto character = TakeFromPool(RecordIndex))
+	{
+		Records[RecordIndex].Character = character;
+		HydratedRecords.Add(RecordIndex);
+	}
+}
+
+void UCameleonCrowdSubsystem::DehydrateRecord(const int32 RecordIndex)
+{
+	auto& record = Records[RecordIndex];
+	const auto character = record.Character;
+
+	// Keep whatever the character has become while it was hydrated
+
+	record.Location = character->GetActorLocation();
+	record.Yaw = character->GetActorRotation().Yaw;
+	record.Tags = character->GetGameplayTags();
+	record.Pose = character->CrowdPose;
+	record.Character = nullptr;
+
+	RecordGrid.Update(RecordIndex, record.Location);
+	HydratedRecords.RemoveSingleSwap(RecordIndex, false);
+
+	character->CrowdRecordIndex = INDEX_NONE;
+	ReturnToPool(character, record.ArchetypeIndex);
+}
+
+void UCameleonCrowdSubsystem::RemoveRecord(const int32 RecordIndex)
+{
+	const int32 lastIndex = Records.Num() - 1;
+
+	RecordGrid.Remove(RecordIndex);
+	HydratedRecords.RemoveSingleSwap(RecordIndex, false);
+
+	// The last record takes the place of the removed one, everything referring to it by index has to follow
+
+	if (RecordIndex != lastIndex)
+	{
+		const auto& lastRecord = Records[lastIndex];
+
+		RecordGrid.Remove(lastIndex);
+		RecordGrid.Add(RecordIndex, lastRecord.Location);
+
+		if (lastRecord.Character)
+		{
+			lastRecord.Character->CrowdRecordIndex = RecordIndex;
+			HydratedRecords[HydratedRecords.Find(lastIndex)] = RecordIndex;
+		}
+	}
+
+	Records.RemoveAtSwap(RecordIndex, 1, false);
+}
+
+int32 UCameleonCrowdSubsystem::FindOrAddArchetype(UClass* Class)
+{
+	const int32 archetypeIndex = Archetypes.IndexOfByPredicate([Class](const FCameleonCrowdArchetype& Archetype)
+	{
+		return Archetype.Class == Class;
+	});
+
+	if (archetypeIndex != INDEX_NONE)
+	{
+		return archetypeIndex;
+	}
+
+	check(Archetypes.Num() < MAX_uint16);
+
+	auto& archetype = Archetypes.AddDefaulted_GetRef();
+	archetype.Class = Class;
+	return Archetypes.Num() - 1;
+}
+
+ACameleonGameCharacter* UCameleonCrowdSubsystem::TakeFromPool(const int32 RecordIndex)
+{
+	const auto& record = Records[RecordIndex];
+	auto& archetype = Archetypes[record.ArchetypeIndex];
+	const FTransform transform(FRotator(0.f, record.Yaw, 0.f), record.Location);
+
+	if (archetype.FreeCharacters.Num() > 0)
+	{
+		auto character = archetype.FreeCharacters.Pop(false);
+		character->CrowdRecordIndex = RecordIndex;
+		character->GameplayTags = record.Tags;
+		character->CrowdPose = record.Pose;
+		character->SetActorTransform(transform, false, nullptr, ETeleportType::ResetPhysics);
+
+		SetCharacterPooled(character, false);
+		character->RegisterWithSubsystems();
+		return character;
+	}
+
+	// The record is set up before the character begins play, so that it registers with the right tags and
+	// doesn't join the crowd a second time
+
+	auto character = GetWorld()->SpawnActorDeferred<ACameleonGameCharacter>(
+		archetype.Class, transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+
+	if (!character)
+	{
+		return nullptr;
+	}
+
+	character->CrowdRecordIndex = RecordIndex;
+	character->GameplayTags = record.Tags;
+	character->CrowdPose = record.Pose;
+	character->FinishSpawning(transform);
+
+	return character;
+}
+
+void UCameleonCrowdSubsystem::ReturnToPool(ACameleonGameCharacter* Character, const int32 ArchetypeIndex)
+{
+	Character->UnregisterFromSubsystems();
+
+	auto& archetype = Archetypes[ArchetypeIndex];
+	if (archetype.FreeCharacters.Num() >= MaxPoolSize)
+	{
+		Character->Destroy();
+		return;
+	}
+
+	SetCharacterPooled(Character, true);
+	archetype.FreeCharacters.Add(Character);
+}
+
+void UCameleonCrowdSubsystem::SetCharacterPooled(ACameleonGameCharacter* Character, const bool bPooled)
+{
+	// A pooled character is neither seen, hit, simulated nor replicated until it's hydrated again
+
+	auto movement = Character->GetCharacterMovement();
+	if (bPooled)
+	{
+		movement->StopMovementImmediately();
+	}
+
+	Character->SetActorHiddenInGame(bPooled);
+	Character->SetActorEnableCollision(!bPooled);
+	Character->SetActorTickEnabled(!bPooled);
+	movement->SetComponentTickEnabled(!bPooled);
+	Character->GetMesh()->SetComponentTickEnabled(!bPooled);
+
+	if (bPooled)
+	{
+		// The clients get the hidden state before the channel goes dormant
+		Character->ForceNetUpdate();
+		Character->SetNetDormancy(DORM_DormantAll);
+	}
+	else
+	{
+		Character->SetNetDormancy(DORM_Awake);
+	}
+}
+
+bool UCameleonCrowdSubsystem::IsTickable() const
+{
+	return Records.Num() > 0;
+}
+
+ETickableTickType UCameleonCrowdSubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonCrowdSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonCrowdSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
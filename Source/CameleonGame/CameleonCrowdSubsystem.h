@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GameplayTagContainer.h"
+#include "CameleonCrowdAnimationSubsystem.h"
+#include "CameleonSpatialHash.h"
+#include "CameleonCrowdSubsystem.generated.h"
+
+class ACameleonGameCharacter;
+
+// Everything needed to bring a crowd character back, kept while it has no actor. The characters stand upright //
+// so the yaw is all there is to their rotation //
+USTRUCT()
+struct FCameleonCrowdRecord
+{
+	GENERATED_BODY()
+
+	FVector Location = FVector::ZeroVector;
+
+	float Yaw = 0.f;
+
+	FGameplayTagContainer Tags;
+
+	// Index of the character class in the crowd subsystem's archetypes //
+	uint16 ArchetypeIndex = 0;
+
+	ECameleonCrowdPose Pose = ECameleonCrowdPose::Idle;
+
+	// Actor the record has been hydrated into, nullptr while it's only a record //
+	UPROPERTY()
+	ACameleonGameCharacter* Character = nullptr;
+};
+
+// Character class of the crowd along with its characters waiting in the pool //
+USTRUCT()
+struct FCameleonCrowdArchetype
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<ACameleonGameCharacter> Class;
+
+	// Hidden characters without collision nor tick, ready to be hydrated //
+	UPROPERTY()
+	TArray<ACameleonGameCharacter*> FreeCharacters;
+};
+
+// Keeps the switchable characters far from the players as compact records instead of full characters so that //
+// the level can hold tens of thousands of them. A record is hydrated into a character taken from a pool once it //
+// comes within the reach of a player's scan volume, the character turns back into a record and returns to the //
+// pool once it's left that reach and stands still. Runs on the server only, the hydrated characters replicate //
+// as usual //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonCrowdSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	bool IsCrowdEnabled() const;
+
+	// Called by the characters as they begin play, the ones controlled by a player are never dehydrated //
+	void RegisterCharacter(ACameleonGameCharacter* Character);
+
+	// Called by the characters as they end play, a destroyed hydrated character takes its record along //
+	void UnregisterCharacter(ACameleonGameCharacter* Character);
+
+	int32 Num() const
+	{
+		return Records.Num();
+	}
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	// Hydrates the records within the players' reach and dehydrates the characters which have left it //
+	void UpdateCrowd();
+
+	void HydrateRecord(int32 RecordIndex);
+	void DehydrateRecord(int32 RecordIndex);
+
+	// Removes the record by swapping the last one in its place //
+	void RemoveRecord(int32 RecordIndex);
+
+	int32 FindOrAddArchetype(UClass* Class);
+
+	// Returns a character of the record's archetype placed where the record is, spawns it if the pool is empty //
+	ACameleonGameCharacter* TakeFromPool(int32 RecordIndex);
+
+	// Takes the character out of play, destroys it instead if the pool is full //
+	void ReturnToPool(ACameleonGameCharacter* Character, int32 ArchetypeIndex);
+
+	static void SetCharacterPooled(ACameleonGameCharacter* Character, bool bPooled);
+
+	// Set the crowd mode on, the characters are full actors all the time otherwise //
+	UPROPERTY(Config)
+	bool bEnableCrowd = false;
+
+	// Records are hydrated within this distance beyond the reach of the scan volume of a player's view target //
+	UPROPERTY(Config)
+	float HydrationMargin = 1000.f;
+
+	// Extra distance the characters have to move away before they're dehydrated, so they don't flip at the border //
+	UPROPERTY(Config)
+	float DehydrationHysteresis = 500.f;
+
+	// Upper bound of the records hydrated per update, the rest of them waits for the next one //
+	UPROPERTY(Config)
+	int32 MaxHydrationsPerUpdate = 32;
+
+	// Free characters kept per archetype, the characters dehydrated beyond that are destroyed //
+	UPROPERTY(Config)
+	int32 MaxPoolSize = 64;
+
+	// Size of the cells of the grid the records are bucketed in //
+	UPROPERTY(Config)
+	float RecordGridCellSize = 2000.f;
+
+	// Seconds between the updates of the crowd //
+	UPROPERTY(Config)
+	float UpdateInterval = 0.25f;
+
+	UPROPERTY()
+	TArray<FCameleonCrowdRecord> Records;
+
+	UPROPERTY()
+	TArray<FCameleonCrowdArchetype> Archetypes;
+
+	// Indices of the records by their location //
+	TCameleonSpatialHash<int32> RecordGrid;
+
+	// Indices of the records which have been hydrated //
+	TArray<int32> HydratedRecords;
+
+	// Scratch buffers for the players' view targets along with the reach of their scan volumes //
+	TArray<FVector> ViewerLocations;
+	TArray<float> ViewerReaches;
+
+	// Scratch buffer for the records found in the grid //
+	TArray<int32> NearbyRecords;
+
+	float TimeSinceUpdate = 0.f;
+};
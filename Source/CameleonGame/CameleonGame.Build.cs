@@ -8,6 +8,8 @@ public class CameleonGame : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "GameplayTags"});
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "GameplayTags", "NetCore"});
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "AnimationBudgetAllocator", "ReplicationGraph" });
 	}
 }
@@ -1,17 +1,24 @@
 #include "CameleonGameCharacter.h"
 #include "CameleonGameProjectile.h"
+#include "CameleonScanSubsystem.h"
+#include "CameleonMovementLODSubsystem.h"
+#include "CameleonCrowdAnimationSubsystem.h"
+#include "CameleonCrowdSubsystem.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
 #include "GameFramework/InputSettings.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "SkeletalMeshComponentBudgeted.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogFPChar, Warning, All);
 
 //////////////////////////////////////////////////////////////////////////
 // ACameleonGameCharacter
 
-ACameleonGameCharacter::ACameleonGameCharacter()
+ACameleonGameCharacter::ACameleonGameCharacter(const FObjectInitializer& ObjectInitializer)
+	// The animation of the mesh is throttled by the animation budget allocator
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(55.f, 96.0f);
@@ -24,6 +31,10 @@ ACameleonGameCharacter::ACameleonGameCharacter()
 	FirstPersonCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
 	FirstPersonCameraComponent->SetupAttachment(GetMesh(), FName("HeadSocket"));
 	FirstPersonCameraComponent->bUsePawnControlRotation = true;
+
+	// Used when the budget allocator is disabled, the crowd animation subsystem turns them off for the characters
+	// which should animate at the full rate
+	GetMesh()->bEnableUpdateRateOptimizations = true;
 }
 
 void ACameleonGameCharacter::GetOwnedGameplayTags(FGameplayTagContainer& TagContainer) const
@@ -31,10 +42,144 @@ void ACameleonGameCharacter::GetOwnedGameplayTags(FGameplayTagContainer& TagCont
 	TagContainer = GameplayTags;
 }
 
+void ACameleonGameCharacter::SetGameplayTags(const FGameplayTagContainer& InGameplayTags)
+{
+	GameplayTags = InGameplayTags;
+	NotifyGameplayTagsChanged();
+}
+
+void ACameleonGameCharacter::AddGameplayTag(const FGameplayTag Tag)
+{
+	if (!GameplayTags.HasTagExact(Tag))
+	{
+		GameplayTags.AddTag(Tag);
+		NotifyGameplayTagsChanged();
+	}
+}
+
+void ACameleonGameCharacter::RemoveGameplayTag(const FGameplayTag Tag)
+{
+	if (GameplayTags.RemoveTag(Tag))
+	{
+		NotifyGameplayTagsChanged();
+	}
+}
+
+void ACameleonGameCharacter::NotifyGameplayTagsChanged()
+{
+	// Characters which haven't begun play yet are evaluated when they register
+	if (const auto world = GetWorld())
+	{
+		if (auto scanSubsystem = world->GetSubsystem<UCameleonScanSubsystem>())
+		{
+			scanSubsystem->UpdateCharacterQueries(this);
+		}
+	}
+}
+
 void ACameleonGameCharacter::BeginPlay()
 {
 	// Call the base class  
 	Super::BeginPlay();
+
+	RegisterWithSubsystems();
+
+	// The characters far from the players are turned into crowd records on the next update of the crowd
+	if (auto crowdSubsystem = GetWorld()->GetSubsystem<UCameleonCrowdSubsystem>())
+	{
+		crowdSubsystem->RegisterCharacter(this);
+	}
+}
+
+void ACameleonGameCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto crowdSubsystem = GetWorld()->GetSubsystem<UCameleonCrowdSubsystem>())
+	{
+		crowdSubsystem->UnregisterCharacter(this);
+	}
+
+	UnregisterFromSubsystems();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACameleonGameCharacter::RegisterWithSubsystems()
+{
+	if (auto scanSubsystem = GetWorld()->GetSubsystem<UCameleonScanSubsystem>())
+	{
+		scanSubsystem->RegisterCharacter(this);
+	}
+
+	if (auto movementLODSubsystem = GetWorld()->GetSubsystem<UCameleonMovementLODSubsystem>())
+	{
+		movementLODSubsystem->RegisterCharacter(this);
+	}
+
+	if (auto crowdAnimationSubsystem = GetWorld()->GetSubsystem<UCameleonCrowdAnimationSubsystem>())
+	{
+		crowdAnimationSubsystem->RegisterCharacter(this);
+	}
+}
+
+void ACameleonGameCharacter::UnregisterFromSubsystems()
+{
+	if (auto scanSubsystem = GetWorld()->GetSubsystem<UCameleonScanSubsystem>())
+	{
+		scanSubsystem->UnregisterCharacter(this);
+	}
+
+	if (auto movementLODSubsystem = GetWorld()->GetSubsystem<UCameleonMovementLODSubsystem>())
+	{
+		movementLODSubsystem->UnregisterCharacter(this);
+	}
+
+	if (auto crowdAnimationSubsystem = GetWorld()->GetSubsystem<UCameleonCrowdAnimationSubsystem>())
+	{
+		crowdAnimationSubsystem->UnregisterCharacter(this);
+	}
+}
+
+void ACameleonGameCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	WakeMovement();
+}
+
+void ACameleonGameCharacter::PawnClientRestart()
+{
+	// The input would be dropped while the movement of a dormant body waits for the next LOD update
+	WakeMovement();
+
+	Super::PawnClientRestart();
+}
+
+void ACameleonGameCharacter::LaunchCharacter(const FVector LaunchVelocity, const bool bXYOverride, const bool bZOverride)
+{
+	WakeMovement();
+
+	Super::LaunchCharacter(LaunchVelocity, bXYOverride, bZOverride);
+}
+
+void ACameleonGameCharacter::NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp,
+                                       const bool bSelfMoved, const FVector HitLocation, const FVector HitNormal,
+                                       const FVector NormalImpulse, const FHitResult& Hit)
+{
+	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
+
+	// Something has bumped into us, e.g. another character or a projectile
+	if (!bSelfMoved)
+	{
+		WakeMovement();
+	}
+}
+
+void ACameleonGameCharacter::WakeMovement()
+{
+	if (auto movementLODSubsystem = GetWorld()->GetSubsystem<UCameleonMovementLODSubsystem>())
+	{
+		movementLODSubsystem->WakeCharacter(this);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
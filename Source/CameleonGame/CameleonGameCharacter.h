@@ -6,6 +6,8 @@
 #include "GameFramework/Character.h"
 #include "GameplayTags.h"
 #include "GameplayTagContainer.h"
+#include "CameleonMovementLODSubsystem.h"
+#include "CameleonCrowdAnimationSubsystem.h"
 #include "CameleonGameCharacter.generated.h"
 
 class UInputComponent;
@@ -15,7 +17,7 @@ class ACameleonGameCharacter : public ACharacter, public IGameplayTagAssetInterf
 {
 	GENERATED_BODY()
 public:
-	ACameleonGameCharacter();
+	ACameleonGameCharacter(const FObjectInitializer& ObjectInitializer);
 
 	virtual void GetOwnedGameplayTags(FGameplayTagContainer& TagContainer) const override;
 
@@ -33,13 +35,56 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
 	float BaseLookUpRate;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	FGameplayTagContainer GameplayTags;
+	const FGameplayTagContainer& GetGameplayTags() const
+	{
+		return GameplayTags;
+	}
+
+	// The tags have to be changed through the setters so the scan queries matching the character are updated //
+
+	UFUNCTION(BlueprintSetter)
+	void SetGameplayTags(const FGameplayTagContainer& InGameplayTags);
+
+	UFUNCTION(BlueprintCallable, Category = Gameplay)
+	void AddGameplayTag(FGameplayTag Tag);
+
+	UFUNCTION(BlueprintCallable, Category = Gameplay)
+	void RemoveGameplayTag(FGameplayTag Tag);
+
+	// Pose shared with the other characters while standing still far from the players, e.g. set it to Selfie //
+	// while the character is taking a selfie //
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation)
+	ECameleonCrowdPose CrowdPose = ECameleonCrowdPose::Idle;
+
+	ECameleonMovementLOD GetMovementLOD() const
+	{
+		return MovementLOD;
+	}
+
+	// Wakes the movement up on the owning client, where PossessedBy isn't called
+	virtual void PawnClientRestart() override;
+
+	// Wakes the movement up if it's dormant
+	virtual void LaunchCharacter(FVector LaunchVelocity, bool bXYOverride, bool bZOverride) override;
+
+	virtual void NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp,
+	                       bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse,
+	                       const FHitResult& Hit) override;
+
+	// Checks if the character matches the query registered in the scan subsystem under the index //
+	FORCEINLINE bool MatchesScanQuery(const int32 QueryIndex) const
+	{
+		return QueryIndex != INDEX_NONE && (ScanQueryMask & (1u << QueryIndex)) != 0;
+	}
 
 protected:
 
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PossessedBy(AController* NewController) override;
+
 	/** Handles moving forward/backward */
 	void MoveForward(float Val);
 
@@ -66,6 +111,38 @@ protected:
 	// End of APawn interface
 
 private:
+	friend class UCameleonScanSubsystem;
+	friend class UCameleonMovementLODSubsystem;
+	friend class UCameleonCrowdSubsystem;
+
+	// Brings the movement back to the full simulation
+	void WakeMovement();
+
+	// Adds the character to the subsystems keeping track of the characters in play, the crowd subsystem //
+	// takes the pooled characters out of them //
+	void RegisterWithSubsystems();
+	void UnregisterFromSubsystems();
+
+	void NotifyGameplayTagsChanged();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetGameplayTags, Category = Gameplay,
+		meta = (AllowPrivateAccess = "true"))
+	FGameplayTagContainer GameplayTags;
+
+	// Bit N is set if the character matches the N-th query registered in the scan subsystem //
+	uint32 ScanQueryMask = 0;
+
+	// Movement level of detail and the times used to pick it, managed by the movement LOD subsystem //
+
+	ECameleonMovementLOD MovementLOD = ECameleonMovementLOD::Full;
+
+	float MovementIdleSince = 0.f;
+
+	float MovementWakeTime = 0.f;
+
+	// Record of the crowd subsystem the character has been hydrated from, INDEX_NONE if it's not part of //
+	// the crowd or it's waiting in the pool //
+	int32 CrowdRecordIndex = INDEX_NONE;
 
 	/** First person camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Camera, meta = (AllowPrivateAccess = "true"))
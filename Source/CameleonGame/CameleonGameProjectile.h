@@ -6,6 +6,7 @@
 #include "GameFramework/Actor.h"
 #include "CameleonGameProjectile.generated.h"
 
+// Visual of a projectile simulated by UCameleonProjectileSubsystem, pooled and moved by it //
 UCLASS(config=Game)
 class ACameleonGameProjectile : public AActor
 {
@@ -0,0 +1,319 @@
+#include "CameleonInteractableBuffer.h"
+#include "Interactable.h"
+#include "Components/SceneComponent.h"
+#include "Math/VectorRegister.h"
+
+// Index of the location for which the dot product of the eye vector and the direction towards it is the largest
+static int32 FindMostFacedIndex(const float* LocationsX,
+                                const float* LocationsY,
+                                const float* LocationsZ,
+                                const int32 NumLocations,
+                                const FVector& EyesPosition,
+                                const FVector& EyeVector)
+{
+	// Score four locations at once, each lane keeps track of the best dot product it has seen
+	// and the index of the location it belongs to (stored as a float, exact for any sane count)
+
+	const auto eyesX = VectorSetFloat1(EyesPosition.X);
+	const auto eyesY = VectorSetFloat1(EyesPosition.Y);
+	const auto eyesZ = VectorSetFloat1(EyesPosition.Z);
+
+	const auto eyeVectorX = VectorSetFloat1(EyeVector.X);
+	const auto eyeVectorY = VectorSetFloat1(EyeVector.Y);
+	const auto eyeVectorZ = VectorSetFloat1(EyeVector.Z);
+
+	const auto laneStep = VectorSetFloat1(4.f);
+
+	// Both paths normalize exactly, with the same floor on the length, so a location scores the same whatever its
+	// lane and one sitting right at the eyes doesn't turn the dot product into a NaN
+	const auto minLengthSquared = VectorSetFloat1(SMALL_NUMBER);
+
+	auto bestDots = VectorSetFloat1(-MAX_FLT);
+	auto bestIndices = VectorSetFloat1(-1.f);
+	auto indices = MakeVectorRegister(0.f, 1.f, 2.f, 3.f);
+
+	const int32 numVectorized = NumLocations & ~3;
+
+	for (int32 index = 0; index < numVectorized; index += 4)
+	{
+		const auto toX = VectorSubtract(VectorLoad(&LocationsX[index]), eyesX);
+		const auto toY = VectorSubtract(VectorLoad(&LocationsY[index]), eyesY);
+		const auto toZ = VectorSubtract(VectorLoad(&LocationsZ[index]), eyesZ);
+
+		auto lengthSquared = VectorMultiply(toX, toX);
+		lengthSquared = VectorMultiplyAdd(toY, toY, lengthSquared);
+		lengthSquared = VectorMultiplyAdd(toZ, toZ, lengthSquared);
+
+		auto dots = VectorMultiply(toX, eyeVectorX);
+		dots = VectorMultiplyAdd(toY, eyeVectorY, dots);
+		dots = VectorMultiplyAdd(toZ, eyeVectorZ, dots);
+		dots = VectorMultiply(dots, VectorReciprocalSqrtAccurate(VectorMax(lengthSquared, minLengthSquared)));
+
+		const auto isBetter = VectorCompareGT(dots, bestDots);
+		bestDots = VectorSelect(isBetter, dots, bestDots);
+		bestIndices = VectorSelect(isBetter, indices, bestIndices);
+
+		indices = VectorAdd(indices, laneStep);
+	}
+
+	// Reduce the lanes, ties go to the location that comes first
+
+	float laneDots[4];
+	float laneIndices[4];
+	VectorStore(bestDots, laneDots);
+	VectorStore(bestIndices, laneIndices);
+
+	float largestDot = -MAX_FLT;
+	int32 bestIndex = INDEX_NONE;
+
+	for (int32 lane = 0; lane < 4; ++lane)
+	{
+		const int32 laneIndex = static_cast<int32>(laneIndices[lane]);
+		if (laneIndex != INDEX_NONE &&
+			(bestIndex == INDEX_NONE || laneDots[lane] > largestDot ||
+				(laneDots[lane] == largestDot && laneIndex < bestIndex)))
+		{
+			largestDot = laneDots[lane];
+			bestIndex = laneIndex;
+		}
+	}
+
+	// Leftovers which didn't fill a whole vector
+
+	for (int32 index = numVectorized; index < NumLocations; ++index)
+	{
+		const auto toLocation = FVector(LocationsX[index], LocationsY[index], LocationsZ[index]) - EyesPosition;
+		const auto currentDot = FVector::DotProduct(EyeVector, toLocation) *
+			FMath::InvSqrt(FMath::Max(toLocation.SizeSquared(), SMALL_NUMBER));
+
+		if (bestIndex == INDEX_NONE || currentDot > largestDot)
+		{
+			largestDot = currentDot;
+			bestIndex = index;
+		}
+	}
+
+	return bestIndex;
+}
+
+void FCameleonInteractableBuffer::Add(AActor* Interactable)
+{
+	if (!Interactable || Contains(Interactable))
+	{
+		return;
+	}
+
+	const auto location = FInteractableCalls::GetInteractableLocation(Interactable);
+
+	Indices.Add(Interactable, Actors.Add(Interactable));
+	LocationsX.Add(location.X);
+	LocationsY.Add(location.Y);
+	LocationsZ.Add(location.Z);
+	Useable.Add(FInteractableCalls::IsUseable(Interactable));
+
+	if (!FInteractableCalls::ReportsUseableChanges(Interactable))
+	{
+		PolledUseable.Add(Actors.Num() - 1);
+	}
+
+	// We'll be notified whenever the interactable moves so we don't have to poll its location
+
+	FDelegateHandle movedHandle;
+	if (auto rootComponent = Interactable->GetRootComponent())
+	{
+		movedHandle = rootComponent->TransformUpdated.AddRaw(this, &FCameleonInteractableBuffer::OnInteractableMoved);
+	}
+	MovedHandles.Add(movedHandle);
+
+	++Version;
+}
+
+void FCameleonInteractableBuffer::Remove(AActor* Interactable)
+{
+	if (const auto index = Indices.Find(Interactable))
+	{
+		RemoveAt(*index);
+	}
+}
+
+void FCameleonInteractableBuffer::Empty()
+{
+	for (int32 index = 0; index < Actors.Num(); ++index)
+	{
+		if (IsValid(Actors[index]) && Actors[index]->GetRootComponent())
+		{
+			Actors[index]->GetRootComponent()->TransformUpdated.Remove(MovedHandles[index]);
+		}
+	}
+
+	Actors.Empty();
+	LocationsX.Empty();
+	LocationsY.Empty();
+	LocationsZ.Empty();
+	Useable.Empty();
+	PolledUseable.Empty();
+	MovedHandles.Empty();
+	Indices.Empty();
+	MovedInteractables.Empty();
+
+	++Version;
+}
+
+void FCameleonInteractableBuffer::RemoveAt(const int32 Index)
+{
+	auto interactable = Actors[Index];
+	if (IsValid(interactable) && interactable->GetRootComponent())
+	{
+		interactable->GetRootComponent()->TransformUpdated.Remove(MovedHandles[Index]);
+	}
+
+	Indices.Remove(interactable);
+	MovedInteractables.Remove(interactable);
+
+	Actors.RemoveAtSwap(Index, 1, false);
+	LocationsX.RemoveAtSwap(Index, 1, false);
+	LocationsY.RemoveAtSwap(Index, 1, false);
+	LocationsZ.RemoveAtSwap(Index, 1, false);
+	Useable.RemoveAtSwap(Index, 1, false);
+	MovedHandles.RemoveAtSwap(Index, 1, false);
+
+	// Fix up the index of the interactable that took the place of the removed one
+
+	PolledUseable.RemoveSingleSwap(Index, false);
+
+	if (Index < Actors.Num())
+	{
+		Indices.Add(Actors[Index], Index);
+
+		const int32 polledIndex = PolledUseable.Find(Actors.Num());
+		if (polledIndex != INDEX_NONE)
+		{
+			PolledUseable[polledIndex] = Index;
+		}
+	}
+
+	++Version;
+}
+
+void FCameleonInteractableBuffer::Refresh(TArray<AActor*>* OutRefreshed)
+{
+	if (MovedInteractables.Num() == 0)
+	{
+		return;
+	}
+
+	for (auto interactable : MovedInteractables)
+	{
+		if (const auto index = Indices.Find(interactable))
+		{
+			const auto location = FInteractableCalls::GetInteractableLocation(interactable);
+			LocationsX[*index] = location.X;
+			LocationsY[*index] = location.Y;
+			LocationsZ[*index] = location.Z;
+
+			if (OutRefreshed)
+			{
+				OutRefreshed->Add(interactable);
+			}
+		}
+	}
+
+	MovedInteractables.Reset();
+	++Version;
+}
+
+bool FCameleonInteractableBuffer::GetLocation(const AActor* Interactable, FVector& OutLocation) const
+{
+	if (const auto index = Indices.Find(Interactable))
+	{
+		OutLocation = FVector(LocationsX[*index], LocationsY[*index], LocationsZ[*index]);
+		return true;
+	}
+
+	return false;
+}
+
+bool FCameleonInteractableBuffer::IsUseable(const AActor* Interactable) const
+{
+	const auto index = Indices.Find(Interactable);
+	return index && Useable[*index];
+}
+
+bool FCameleonInteractableBuffer::RefreshUseable(const AActor* Interactable)
+{
+	const auto index = Indices.Find(Interactable);
+	if (!index)
+	{
+		return false;
+	}
+
+	const bool bUseable = FInteractableCalls::IsUseable(Interactable);
+	if (Useable[*index] == bUseable)
+	{
+		return false;
+	}
+
+	Useable[*index] = bUseable;
+	return true;
+}
+
+bool FCameleonInteractableBuffer::RefreshPolledUseable()
+{
+	bool bChanged = false;
+
+	for (const int32 index : PolledUseable)
+	{
+		const bool bUseable = IsValid(Actors[index]) && FInteractableCalls::IsUseable(Actors[index]);
+		bChanged |= Useable[index] != bUseable;
+		Useable[index] = bUseable;
+	}
+
+	return bChanged;
+}
+
+void FCameleonInteractableBuffer::OnInteractableMoved(USceneComponent* UpdatedComponent,
+                                                      EUpdateTransformFlags UpdateTransformFlags,
+                                                      ETeleportType Teleport)
+{
+	MovedInteractables.Add(UpdatedComponent->GetOwner());
+}
+
+AActor* FCameleonInteractableBuffer::FindMostFaced(const FVector& EyesPosition, const FVector& EyeVector) const
+{
+	const int32 bestIndex = FindMostFacedIndex(LocationsX.GetData(), LocationsY.GetData(), LocationsZ.GetData(),
+	                                           Actors.Num(), EyesPosition, EyeVector);
+
+	return bestIndex != INDEX_NONE ? Actors[bestIndex] : nullptr;
+}
+
+void FCameleonInteractableBuffer::Snapshot(const TArray<AActor*>& Subset, FCameleonInteractableSnapshot& OutSnapshot) const
+{
+	for (const auto interactable : Subset)
+	{
+		const int32 index = Indices.FindChecked(interactable);
+		OutSnapshot.Actors.Add(interactable);
+		OutSnapshot.LocationsX.Add(LocationsX[index]);
+		OutSnapshot.LocationsY.Add(LocationsY[index]);
+		OutSnapshot.LocationsZ.Add(LocationsZ[index]);
+	}
+}
+
+void FCameleonInteractableSnapshot::Reset(const FVector& InEyesPosition, const FVector& InEyeVector,
+                                          const int32 ExpectedNum)
+{
+	EyesPosition = InEyesPosition;
+	EyeVector = InEyeVector;
+
+	Actors.Reset(ExpectedNum);
+	LocationsX.Reset(ExpectedNum);
+	LocationsY.Reset(ExpectedNum);
+	LocationsZ.Reset(ExpectedNum);
+}
+
+AActor* FCameleonInteractableSnapshot::FindMostFaced() const
+{
+	const int32 bestIndex = FindMostFacedIndex(LocationsX.GetData(), LocationsY.GetData(), LocationsZ.GetData(),
+	                                           Actors.Num(), EyesPosition, EyeVector);
+
+	return bestIndex != INDEX_NONE ? Actors[bestIndex] : nullptr;
+}
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CameleonInteractableBuffer.generated.h"
+
+// Interactables within the reach of a player along with their cached locations and the player's view, //
+// copied on the game thread so that the one the player is facing can be found on any thread //
+struct CAMELEONGAME_API FCameleonInteractableSnapshot
+{
+	FVector EyesPosition = FVector::ZeroVector;
+
+	FVector EyeVector = FVector::ForwardVector;
+
+	TArray<AActor*> Actors;
+
+	TArray<float> LocationsX;
+	TArray<float> LocationsY;
+	TArray<float> LocationsZ;
+
+	void Reset(const FVector& InEyesPosition, const FVector& InEyeVector, int32 ExpectedNum);
+
+	// Returns the interactable for which the dot product of the eye vector and the direction towards it //
+	// is the largest, nullptr if there are none. Only reads the copied data //
+	AActor* FindMostFaced() const;
+};
+
+// Interactables along with their cached locations, kept as a structure of arrays so that finding //
+// the one the player is facing doesn't have to go through the Blueprint VM every frame //
+USTRUCT()
+struct CAMELEONGAME_API FCameleonInteractableBuffer
+{
+	GENERATED_BODY()
+
+public:
+	void Add(AActor* Interactable);
+
+	void Remove(AActor* Interactable);
+
+	// Has to be called before the owner of the buffer goes away //
+	void Empty();
+
+	bool Contains(const AActor* Interactable) const
+	{
+		return Indices.Contains(Interactable);
+	}
+
+	int32 Num() const
+	{
+		return Actors.Num();
+	}
+
+	// Re-fetches the locations of the interactables that have moved since the last refresh, //
+	// optionally appends the refreshed ones to the array //
+	void Refresh(TArray<AActor*>* OutRefreshed = nullptr);
+
+	// Cached location of the interactable, returns false if it's not in the buffer //
+	bool GetLocation(const AActor* Interactable, FVector& OutLocation) const;
+
+	// Cached useable state of the interactable, false if it's not in the buffer //
+	bool IsUseable(const AActor* Interactable) const;
+
+	// Re-fetches the useable state of the interactable, returns true if it has changed //
+	bool RefreshUseable(const AActor* Interactable);
+
+	// Re-fetches the useable states of the interactables which don't report their changes, //
+	// returns true if any of them has changed //
+	bool RefreshPolledUseable();
+
+	// Returns the interactable for which the dot product of the eye vector and the direction //
+	// towards the interactable is the largest, nullptr if there are no interactables //
+	AActor* FindMostFaced(const FVector& EyesPosition, const FVector& EyeVector) const;
+
+	// Appends the given interactables, which have to be in the buffer, to the snapshot //
+	void Snapshot(const TArray<AActor*>& Subset, FCameleonInteractableSnapshot& OutSnapshot) const;
+
+	// Incremented every time an interactable is added, removed or its location changes //
+	uint32 GetVersion() const
+	{
+		return Version;
+	}
+
+private:
+	void RemoveAt(int32 Index);
+
+	void OnInteractableMoved(USceneComponent* UpdatedComponent,
+	                         EUpdateTransformFlags UpdateTransformFlags,
+	                         ETeleportType Teleport);
+
+	UPROPERTY()
+	TArray<AActor*> Actors;
+
+	// Cached interactable locations //
+
+	TArray<float> LocationsX;
+	TArray<float> LocationsY;
+	TArray<float> LocationsZ;
+
+	// Cached useable states of the interactables, fetched when they're added or reported as changed //
+
+	TArray<bool> Useable;
+
+	// Indices of the interactables which don't report the changes of their useable state //
+
+	TArray<int32> PolledUseable;
+
+	// Handles to the transform updated delegates of the interactables' root components //
+
+	TArray<FDelegateHandle> MovedHandles;
+
+	TMap<const AActor*, int32> Indices;
+
+	// Interactables whose locations have to be re-fetched on the next refresh //
+
+	TSet<AActor*> MovedInteractables;
+
+	uint32 Version = 0;
+};
+
+template <>
+struct TStructOpsTypeTraits<FCameleonInteractableBuffer> : public TStructOpsTypeTraitsBase2<FCameleonInteractableBuffer>
+{
+	enum
+	{
+		// The buffer registers itself to the delegates of the interactables, it must not be copied //
+		WithCopy = false
+	};
+};
@@ -0,0 +1,212 @@
+#include "CameleonInteractableSubsystem.h"
+#include "CameleonProfiling.h"
+#include "Interactable.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+
+bool UCameleonInteractableSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const auto world = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && world && world->IsGameWorld();
+}
+
+void UCameleonInteractableSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	InteractableGrid.SetCellSize(CellSize);
+
+	// The level actors are registered once they're initialized, the spawned ones right away
+
+	WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(
+		this, &UCameleonInteractableSubsystem::OnWorldInitializedActors);
+	LevelAddedToWorldHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(
+		this, &UCameleonInteractableSubsystem::OnLevelAddedToWorld);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &UCameleonInteractableSubsystem::OnActorSpawned));
+}
+
+void UCameleonInteractableSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedToWorldHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	Interactables.Empty();
+	InteractableGrid.Reset();
+
+	Super::Deinitialize();
+}
+
+void UCameleonInteractableSubsystem::RegisterInteractable(AActor* Interactable)
+{
+	if (!Interactable || !Interactable->Implements<UInteractable>() || Interactables.Contains(Interactable))
+	{
+		return;
+	}
+
+	Interactables.Add(Interactable);
+
+	FVector location;
+	Interactables.GetLocation(Interactable, location);
+	InteractableGrid.Add(Interactable, location);
+
+	Interactable->OnEndPlay.AddUniqueDynamic(this, &UCameleonInteractableSubsystem::OnInteractableEndPlay);
+}
+
+void UCameleonInteractableSubsystem::UnregisterInteractable(AActor* Interactable)
+{
+	if (!Interactables.Contains(Interactable))
+	{
+		return;
+	}
+
+	Interactables.Remove(Interactable);
+	InteractableGrid.Remove(Interactable);
+
+	Interactable->OnEndPlay.RemoveDynamic(this, &UCameleonInteractableSubsystem::OnInteractableEndPlay);
+}
+
+void UCameleonInteractableSubsystem::NotifyInteractableChanged(AActor* Interactable)
+{
+	if (Interactables.RefreshUseable(Interactable))
+	{
+		++StateVersion;
+	}
+}
+
+void UCameleonInteractableSubsystem::QueryInteractables(const FVector& Location,
+                                                        const float Reach,
+                                                        TArray<AActor*>& OutInteractables) const
+{
+	OutInteractables.Reset();
+
+	// Broad phase - the cells touched by the bounding box of the reach, then the exact distance
+
+	InteractableGrid.QueryBounds(FBox(Location - FVector(Reach), Location + FVector(Reach)), OutInteractables);
+
+	const float reachSquared = FMath::Square(Reach);
+
+	OutInteractables.RemoveAllSwap([this, &Location, reachSquared](const AActor* Interactable)
+	{
+		FVector interactableLocation;
+		Interactables.GetLocation(Interactable, interactableLocation);
+		return FVector::DistSquared(Location, interactableLocation) > reachSquared;
+	});
+}
+
+AActor* UCameleonInteractableSubsystem::FindMostFaced(const FVector& EyesPosition,
+                                                      const FVector& EyeVector,
+                                                      const float Reach) const
+{
+	SnapshotInteractables(EyesPosition, EyeVector, Reach, MostFacedSnapshot);
+	return MostFacedSnapshot.FindMostFaced();
+}
+
+void UCameleonInteractableSubsystem::SnapshotInteractables(const FVector& EyesPosition,
+                                                           const FVector& EyeVector,
+                                                           const float Reach,
+                                                           FCameleonInteractableSnapshot& OutSnapshot) const
+{
+	QueryInteractables(EyesPosition, Reach, InteractablesInReach);
+
+	// The useable states are cached, no Blueprint is called here
+	InteractablesInReach.RemoveAllSwap([this](const AActor* Interactable)
+	{
+		return !Interactables.IsUseable(Interactable);
+	});
+
+	// Keep the order stable so the ties don't depend on the order of the cells
+	InteractablesInReach.Sort();
+
+	OutSnapshot.Reset(EyesPosition, EyeVector, InteractablesInReach.Num());
+	Interactables.Snapshot(InteractablesInReach, OutSnapshot);
+}
+
+void UCameleonInteractableSubsystem::Tick(const float DeltaTime)
+{
+	// Move the interactables which have moved since the last tick to their new cells
+
+	MovedInteractables.Reset();
+	Interactables.Refresh(&MovedInteractables);
+
+	for (auto interactable : MovedInteractables)
+	{
+		FVector location;
+		Interactables.GetLocation(interactable, location);
+		InteractableGrid.Update(interactable, location);
+	}
+
+	// The interactables implemented in Blueprint don't report the changes of their useable state
+	if (Interactables.RefreshPolledUseable())
+	{
+		++StateVersion;
+	}
+
+	INC_DWORD_STAT_BY(STAT_Cameleon_InteractablesTracked, Interactables.Num());
+	CSV_CUSTOM_STAT(Cameleon, InteractablesTracked, Interactables.Num(), ECsvCustomStatOp::Set);
+}
+
+void UCameleonInteractableSubsystem::RegisterLevelInteractables(ULevel* Level)
+{
+	if (!Level)
+	{
+		return;
+	}
+
+	for (auto actor : Level->Actors)
+	{
+		RegisterInteractable(actor);
+	}
+}
+
+void UCameleonInteractableSubsystem::OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	if (Params.World != GetWorld())
+	{
+		return;
+	}
+
+	for (auto level : Params.World->GetLevels())
+	{
+		RegisterLevelInteractables(level);
+	}
+}
+
+void UCameleonInteractableSubsystem::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		RegisterLevelInteractables(Level);
+	}
+}
+
+void UCameleonInteractableSubsystem::OnActorSpawned(AActor* Actor)
+{
+	RegisterInteractable(Actor);
+}
+
+void UCameleonInteractableSubsystem::OnInteractableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterInteractable(Actor);
+}
+
+bool UCameleonInteractableSubsystem::IsTickable() const
+{
+	return Interactables.Num() > 0;
+}
+
+ETickableTickType UCameleonInteractableSubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonInteractableSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonInteractableSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonInteractableSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
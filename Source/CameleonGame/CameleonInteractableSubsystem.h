@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CameleonInteractableBuffer.h"
+#include "CameleonSpatialHash.h"
+#include "CameleonInteractableSubsystem.generated.h"
+
+// Registry of every interactable in the world, they're registered automatically when the level is //
+// initialized, streamed in or when they're spawned. Kept in a uniform spatial hash so that any player //
+// controller can find the interactables within its reach without tracking them itself //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonInteractableSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// Only the game worlds get one, the editor and preview worlds would call into the placed interactables //
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Does nothing if the actor doesn't implement IInteractable //
+	void RegisterInteractable(AActor* Interactable);
+
+	void UnregisterInteractable(AActor* Interactable);
+
+	// Should be called when the interactable's useable state changes, refreshes the cached state so the players //
+	// pick their focus again. AInteractableBase calls it by itself, the Blueprint-only //
+	// interactables are polled every tick but can call it to be picked up right away //
+	UFUNCTION(BlueprintCallable)
+	void NotifyInteractableChanged(AActor* Interactable);
+
+	// Collects the interactables within the distance of the location //
+	void QueryInteractables(const FVector& Location, float Reach, TArray<AActor*>& OutInteractables) const;
+
+	// Returns the useable interactable within the reach for which the dot product of the eye vector and //
+	// the direction towards it is the largest, nullptr if there's none //
+	AActor* FindMostFaced(const FVector& EyesPosition, const FVector& EyeVector, float Reach) const;
+
+	// Copies the useable interactables within the reach, the most faced one can be found from the snapshot //
+	// on a worker thread //
+	void SnapshotInteractables(const FVector& EyesPosition,
+	                           const FVector& EyeVector,
+	                           float Reach,
+	                           FCameleonInteractableSnapshot& OutSnapshot) const;
+
+	int32 GetNumInteractables() const
+	{
+		return Interactables.Num();
+	}
+
+	// Changes every time an interactable is registered, unregistered, moves or changes its state //
+	uint32 GetVersion() const
+	{
+		return Interactables.GetVersion() + StateVersion;
+	}
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	void RegisterLevelInteractables(ULevel* Level);
+
+	void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+
+	void OnActorSpawned(AActor* Actor);
+
+	UFUNCTION()
+	void OnInteractableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	// Size of a single grid cell, should be in the ballpark of the players' reach //
+	UPROPERTY(Config)
+	float CellSize = 1000.f;
+
+	UPROPERTY()
+	FCameleonInteractableBuffer Interactables;
+
+	TCameleonSpatialHash<AActor*> InteractableGrid;
+
+	// Incremented by NotifyInteractableChanged() when the useable state has changed //
+	uint32 StateVersion = 0;
+
+	FDelegateHandle WorldInitializedActorsHandle;
+
+	FDelegateHandle LevelAddedToWorldHandle;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	// Scratch buffers for the moved interactables and the queries //
+
+	TArray<AActor*> MovedInteractables;
+
+	mutable TArray<AActor*> InteractablesInReach;
+
+	mutable FCameleonInteractableSnapshot MostFacedSnapshot;
+};
@@ -0,0 +1,43 @@
+#include "CameleonMappedFile.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+FCameleonMappedFile::~FCameleonMappedFile()
+{
+	Close();
+}
+
+bool FCameleonMappedFile::Open(const FString& Filename)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion());
+	}
+
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedData, *Filename, FILEREAD_Silent))
+	{
+		Data = LoadedData.GetData();
+		Size = LoadedData.Num();
+	}
+
+	return IsOpen();
+}
+
+void FCameleonMappedFile::Close()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedData.Empty();
+	Data = nullptr;
+	Size = 0;
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// Read-only view of a whole file, memory-mapped where the platform supports it and loaded otherwise //
+class CAMELEONGAME_API FCameleonMappedFile
+{
+public:
+	FCameleonMappedFile() = default;
+	~FCameleonMappedFile();
+
+	FCameleonMappedFile(const FCameleonMappedFile&) = delete;
+	FCameleonMappedFile& operator=(const FCameleonMappedFile&) = delete;
+
+	bool Open(const FString& Filename);
+
+	void Close();
+
+	bool IsOpen() const
+	{
+		return Data != nullptr;
+	}
+
+	const uint8* GetData() const
+	{
+		return Data;
+	}
+
+	int64 GetSize() const
+	{
+		return Size;
+	}
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// Contents of the file when it can't be mapped //
+	TArray<uint8> LoadedData;
+
+	const uint8* Data = nullptr;
+
+	int64 Size = 0;
+};
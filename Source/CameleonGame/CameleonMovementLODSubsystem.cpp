@@ -0,0 +1,202 @@
+#include "CameleonMovementLODSubsystem.h"
+#include "CameleonGameCharacter.h"
+#include "CameleonProfiling.h"
+#include "SwitchCharacterComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Movement LOD"), STAT_Cameleon_MovementLOD, STATGROUP_Cameleon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dormant Characters"), STAT_Cameleon_DormantCharacters, STATGROUP_Cameleon);
+
+void UCameleonMovementLODSubsystem::Deinitialize()
+{
+	Characters.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCameleonMovementLODSubsystem::RegisterCharacter(ACameleonGameCharacter* Character)
+{
+	if (!Character || Characters.Contains(Character))
+	{
+		return;
+	}
+
+	Characters.Add(Character);
+
+	// Everyone starts fully simulated so they can settle on the floor first
+	Character->MovementIdleSince = GetWorld()->GetTimeSeconds();
+	Character->MovementWakeTime = GetWorld()->GetTimeSeconds();
+	SetMovementLOD(Character, ECameleonMovementLOD::Full);
+}
+
+void UCameleonMovementLODSubsystem::UnregisterCharacter(ACameleonGameCharacter* Character)
+{
+	if (Characters.RemoveSingleSwap(Character, false) > 0)
+	{
+		SetMovementLOD(Character, ECameleonMovementLOD::Full);
+	}
+}
+
+void UCameleonMovementLODSubsystem::WakeCharacter(ACameleonGameCharacter* Character)
+{
+	Character->MovementIdleSince = GetWorld()->GetTimeSeconds();
+	Character->MovementWakeTime = GetWorld()->GetTimeSeconds();
+	SetMovementLOD(Character, ECameleonMovementLOD::Full);
+}
+
+void UCameleonMovementLODSubsystem::Tick(const float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		TimeSinceUpdate = 0.f;
+		UpdateMovementLODs();
+	}
+}
+
+void UCameleonMovementLODSubsystem::UpdateMovementLODs()
+{
+	SCOPE_CYCLE_COUNTER(STAT_Cameleon_MovementLOD);
+
+	const auto world = GetWorld();
+	const float now = world->GetTimeSeconds();
+
+	// Gather the players' view targets, during a transition that's the character we're switching to,
+	// and the scan volumes
+
+	TArray<const USwitchCharacterComponent*, TInlineAllocator<4>> switchComponents;
+	ViewerLocations.Reset();
+
+	for (auto playerControllerIt = world->GetPlayerControllerIterator(); playerControllerIt; ++playerControllerIt)
+	{
+		const auto playerController = playerControllerIt->Get();
+		if (!playerController)
+		{
+			continue;
+		}
+
+		if (const auto viewTarget = playerController->GetViewTarget())
+		{
+			ViewerLocations.Add(viewTarget->GetActorLocation());
+		}
+
+		if (const auto switchComponent = playerController->FindComponentByClass<USwitchCharacterComponent>())
+		{
+			switchComponents.Add(switchComponent);
+		}
+	}
+
+	const float fullSimulationDistanceSquared = FMath::Square(FullSimulationDistance);
+	int32 numDormant = 0;
+
+	for (auto character : Characters)
+	{
+		const auto movement = character->GetCharacterMovement();
+
+		// Keep track of how long the character has been standing still on the floor
+
+		const bool bIdle = movement->IsMovingOnGround() &&
+			movement->Velocity.IsNearlyZero() &&
+			!character->HasAnyRootMotion();
+
+		if (!bIdle)
+		{
+			character->MovementIdleSince = now;
+		}
+
+		// The players' characters and the ones close to the players are fully simulated, the rest of them
+		// goes dormant once they've been idle for a while. The placed characters are possessed by an AI controller
+
+		bool bRelevant = character->IsPlayerControlled();
+
+		const auto location = character->GetActorLocation();
+		for (int32 viewerIdx = 0; !bRelevant && viewerIdx < ViewerLocations.Num(); ++viewerIdx)
+		{
+			bRelevant = FVector::DistSquared(location, ViewerLocations[viewerIdx]) <= fullSimulationDistanceSquared;
+		}
+
+		for (int32 componentIdx = 0; !bRelevant && componentIdx < switchComponents.Num(); ++componentIdx)
+		{
+			bRelevant = switchComponents[componentIdx]->GetCharactersInScanVolume().Contains(character);
+		}
+
+		auto movementLOD = ECameleonMovementLOD::Reduced;
+		if (bRelevant)
+		{
+			movementLOD = ECameleonMovementLOD::Full;
+		}
+		else if (now - character->MovementIdleSince >= IdleTimeBeforeDormant &&
+			now - character->MovementWakeTime >= WakeGracePeriod)
+		{
+			movementLOD = ECameleonMovementLOD::Dormant;
+			++numDormant;
+		}
+
+		SetMovementLOD(character, movementLOD);
+	}
+
+	SET_DWORD_STAT(STAT_Cameleon_DormantCharacters, numDormant);
+}
+
+void UCameleonMovementLODSubsystem::SetMovementLOD(ACameleonGameCharacter* Character,
+                                                   const ECameleonMovementLOD MovementLOD) const
+{
+	if (Character->MovementLOD == MovementLOD)
+	{
+		return;
+	}
+
+	// Dormant characters don't replicate either until they're woken up
+	if (Character->MovementLOD == ECameleonMovementLOD::Dormant)
+	{
+		Character->SetNetDormancy(DORM_Awake);
+	}
+
+	Character->MovementLOD = MovementLOD;
+
+	auto movement = Character->GetCharacterMovement();
+
+	switch (MovementLOD)
+	{
+	case ECameleonMovementLOD::Full:
+		movement->SetComponentTickInterval(0.f);
+		movement->SetComponentTickEnabled(true);
+		break;
+
+	case ECameleonMovementLOD::Reduced:
+		movement->SetComponentTickInterval(ReducedTickInterval);
+		movement->SetComponentTickEnabled(true);
+		break;
+
+	case ECameleonMovementLOD::Dormant:
+		// The character is idle on the floor already, there's nothing left to simulate
+		movement->StopMovementImmediately();
+		movement->SetComponentTickEnabled(false);
+		Character->SetNetDormancy(DORM_DormantAll);
+		break;
+	}
+}
+
+bool UCameleonMovementLODSubsystem::IsTickable() const
+{
+	return Characters.Num() > 0;
+}
+
+ETickableTickType UCameleonMovementLODSubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonMovementLODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonMovementLODSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonMovementLODSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
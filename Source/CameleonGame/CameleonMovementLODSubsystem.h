@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CameleonMovementLODSubsystem.generated.h"
+
+class ACameleonGameCharacter;
+
+UENUM(BlueprintType)
+enum class ECameleonMovementLOD : uint8
+{
+	// Movement ticks every frame //
+	Full,
+	// Movement ticks at ReducedTickInterval //
+	Reduced,
+	// Movement doesn't tick at all, the character rests on the floor until it's woken up //
+	Dormant
+};
+
+// Lowers the rate at which the movement of the unpossessed characters is simulated the further they are //
+// from the players, characters standing still far away stop simulating and replicating altogether //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonMovementLODSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(ACameleonGameCharacter* Character);
+	void UnregisterCharacter(ACameleonGameCharacter* Character);
+
+	// Brings the character back to the full simulation, e.g. when it's possessed or pushed, //
+	// it doesn't go dormant again for WakeGracePeriod seconds //
+	void WakeCharacter(ACameleonGameCharacter* Character);
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	// Picks the level of detail for every registered character //
+	void UpdateMovementLODs();
+
+	void SetMovementLOD(ACameleonGameCharacter* Character, ECameleonMovementLOD MovementLOD) const;
+
+	// Characters within this distance from a player's view target or inside of a scan volume are fully simulated //
+	UPROPERTY(Config)
+	float FullSimulationDistance = 3000.f;
+
+	// Tick interval of the movement at the reduced level of detail //
+	UPROPERTY(Config)
+	float ReducedTickInterval = 0.1f;
+
+	// Seconds a character has to stand still before it goes dormant //
+	UPROPERTY(Config)
+	float IdleTimeBeforeDormant = 1.f;
+
+	// Seconds after waking up during which the character can't go dormant //
+	UPROPERTY(Config)
+	float WakeGracePeriod = 2.f;
+
+	// Seconds between the updates of the levels of detail //
+	UPROPERTY(Config)
+	float UpdateInterval = 0.25f;
+
+	UPROPERTY()
+	TArray<ACameleonGameCharacter*> Characters;
+
+	// Scratch buffer for the locations of the players' view targets //
+	TArray<FVector> ViewerLocations;
+
+	float TimeSinceUpdate = 0.f;
+};
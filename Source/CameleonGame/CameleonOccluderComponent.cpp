@@ -0,0 +1,62 @@
+#include "CameleonOccluderComponent.h"
+#include "CameleonVisibilitySubsystem.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+UCameleonOccluderComponent::UCameleonOccluderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UCameleonOccluderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LastBounds = GetOwner()->GetComponentsBoundingBox();
+
+	if (auto root = GetOwner()->GetRootComponent())
+	{
+		RootMovedHandle = root->TransformUpdated.AddUObject(this, &UCameleonOccluderComponent::OnRootMoved);
+	}
+}
+
+void UCameleonOccluderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto root = GetOwner()->GetRootComponent())
+	{
+		root->TransformUpdated.Remove(RootMovedHandle);
+	}
+
+	// Nothing blocks the lines through it anymore
+	NotifyOccluderChanged();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCameleonOccluderComponent::OnRootMoved(USceneComponent* UpdatedComponent,
+                                             EUpdateTransformFlags UpdateTransformFlags,
+                                             ETeleportType Teleport)
+{
+	NotifyOccluderChanged();
+}
+
+void UCameleonOccluderComponent::NotifyOccluderChanged()
+{
+	const auto bounds = GetOwner()->GetComponentsBoundingBox();
+
+	if (auto visibilitySubsystem = GetWorld() ? GetWorld()->GetSubsystem<UCameleonVisibilitySubsystem>() : nullptr)
+	{
+		if (LastBounds.IsValid)
+		{
+			visibilitySubsystem->InvalidateLineOfSight(LastBounds);
+		}
+
+		if (bounds.IsValid)
+		{
+			visibilitySubsystem->InvalidateLineOfSight(bounds);
+		}
+	}
+
+	LastBounds = bounds;
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CameleonOccluderComponent.generated.h"
+
+// Marks an actor blocking the line of sight that moves or changes, e.g. a door, the cached line of sight //
+// results passing through its bounds are forgotten whenever it moves or NotifyOccluderChanged() is called //
+UCLASS(ClassGroup = (Cameleon), meta = (BlueprintSpawnableComponent))
+class CAMELEONGAME_API UCameleonOccluderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCameleonOccluderComponent();
+
+	// Should be called when the occluder changes without moving, e.g. when its collision is toggled //
+	UFUNCTION(BlueprintCallable)
+	void NotifyOccluderChanged();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void OnRootMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags,
+	                 ETeleportType Teleport);
+
+	// Bounds of the owner when the cache was last invalidated, the results through them are stale as well //
+	FBox LastBounds = FBox(ForceInit);
+
+	FDelegateHandle RootMovedHandle;
+};
@@ -1,479 +1,145 @@
 #include "CameleonPlayerController.h"
-#include "Components/BoxComponent.h"
+#include "SwitchCharacterComponent.h"
+#include "CameleonSessionSubsystem.h"
+#include "Engine/World.h"
 #include "GameFramework/Character.h"
-#include "Camera/CameraComponent.h"
-#include "Components/CapsuleComponent.h"
-#include "ControllableCharacterMarker.h"
-#include "Interactable.h"
-#include "GameplayTagContainer.h"
-#include "CameleonGameCharacter.h"
 
 ACameleonPlayerController::ACameleonPlayerController()
 {
-	CollisionComponent = CreateDefaultSubobject<UBoxComponent>("CollisionComponent");
-	CollisionComponent->SetRelativeLocation({ScanDistance.X / 2, 0, ScanDistance.Z / 2});
+	SwitchCharacterComponent = CreateDefaultSubobject<USwitchCharacterComponent>("SwitchCharacterComponent");
 
 	bAutoManageActiveCameraTarget = false;
-	bCanSwitch = true;
 }
 
-void ACameleonPlayerController::SetupInputComponent()
+void ACameleonPlayerController::PostInitializeComponents()
 {
-	Super::SetupInputComponent();
-	check(InputComponent);
+	Super::PostInitializeComponents();
 
-	InputComponent->BindAction("NextCharacter", IE_Pressed, this, &ACameleonPlayerController::SetNextAsActive);
-	InputComponent->BindAction("PreviousCharacter", IE_Pressed, this, &ACameleonPlayerController::SetPreviousAsActive);
-	InputComponent->BindAction("SwitchCharacter", IE_Pressed, this, &ACameleonPlayerController::SwitchCharacter);
-	InputComponent->BindAction("UseInteractable", IE_Pressed, this, &ACameleonPlayerController::UseInteractable);
-	InputComponent->BindAction("ToggleScan", IE_Pressed, this, &ACameleonPlayerController::ToggleScanAbility);
+	// The component reads them as it begins play
+	SwitchCharacterComponent->MarkerClass = MarkerClass;
+	SwitchCharacterComponent->TransitionTimeSeconds = TransitionTimeSeconds;
 }
 
 void ACameleonPlayerController::BeginPlay()
 {
-    Super::BeginPlay();
-
-	auto queryExpression = FGameplayTagQueryExpression()
-		.AllTagsMatch()
-		.AddTag(FGameplayTag::RequestGameplayTag("Controllable"));
-
-	ControllableCharacterQuery.Build(queryExpression);
-	
-	CollisionComponent->SetHiddenInGame(false);
+	Super::BeginPlay();
 
-	if (const auto character = GetCharacter())
+	if (auto sessionSubsystem = GetWorld()->GetSubsystem<UCameleonSessionSubsystem>())
 	{
-		if (const auto camera = character->FindComponentByClass<UCameraComponent>())
-		{
-			CurrentCharacterCamera = camera;
-			CollisionComponent->AttachToComponent(camera, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
-			SetViewTarget(character);
-		}
+		sessionSubsystem->RegisterPlayerController(this);
 	}
-
-	FScriptDelegate overlapBeginDelegate;
-	FScriptDelegate overlapEndDelegate;
-
-	overlapBeginDelegate.BindUFunction(this, FName("OnActorBeginOverlap"));
-	overlapEndDelegate.BindUFunction(this, FName("OnActorEndOverlap"));
-
-	//@TODO Remove once we have some nice effect to show the scan region
-	SetActorHiddenInGame(false);
-	CollisionComponent->SetHiddenInGame(true);
-
-	CollisionComponent->SetBoxExtent(ScanDistance);
-	CollisionComponent->SetGenerateOverlapEvents(false);
-	CollisionComponent->OnComponentBeginOverlap.Add(overlapBeginDelegate);
-	CollisionComponent->OnComponentEndOverlap.Add(overlapEndDelegate);
 }
 
-void ACameleonPlayerController::Tick(float DeltaSeconds)
+void ACameleonPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaSeconds);
-
-	// Camera transition
-	if (bInTransition)
+	if (auto sessionSubsystem = GetWorld()->GetSubsystem<UCameleonSessionSubsystem>())
 	{
-		TransitionTimer += DeltaSeconds;
-
-		if (TransitionTimer > TransitionTimeSeconds)
-		{
-			Possess(CharactersInSight[ActiveCharacterIndex]);
-			EnableInput(this);
-
-			ClearControllableCharacters();
-			ActiveAInteractable = nullptr;
-
-			bInTransition = false;
-			bCanSwitch = true;
-
-			Interactables.Empty();
-			if (auto activeInteractable = Cast<IInteractable>(ActiveAInteractable))
-			{
-				activeInteractable->Execute_SetInteractableActive(ActiveAInteractable, false);
-			}
-
-			CollisionComponent->SetGenerateOverlapEvents(true);
-		}
+		sessionSubsystem->UnregisterPlayerController(this);
 	}
 
-	// Interactables
-
-	auto playerCharacter = GetCharacter();
-
-	if (!bInTransition && playerCharacter)
-	{
-		float largestDot = 0;
-		AActor* activeInteractableActor = nullptr;
-		AActor* lastActiveInteractableActor = ActiveAInteractable;
-
-		// Find the interactable that the player is facing by calculating the dot product
-		// of the eye vector and the direction to the interactable
-
-		FVector eyesPos;
-		FRotator viewRotation;
-		playerCharacter->GetActorEyesViewPoint(eyesPos, viewRotation);
-
-		auto eyeVector = CurrentCharacterCamera->GetForwardVector();
-
-		for (auto interactableActor : Interactables)
-		{
-			auto interactable = Cast<IInteractable>(interactableActor);
-			auto interactablePos = interactable->Execute_GetInteractableLocation(interactableActor);
-			auto toInteractable = (interactablePos - eyesPos).GetUnsafeNormal();
-			auto currentDot = FVector::DotProduct(eyeVector, toInteractable);
-
-			if (activeInteractableActor == nullptr || currentDot > largestDot)
-			{
-				largestDot = currentDot;
-				activeInteractableActor = interactableActor;
-			}
-		}
-
-		if (activeInteractableActor)
-		{
-			// if the active interactable has changed
-			if (activeInteractableActor != lastActiveInteractableActor)
-			{
-				// disable the last interactable if we had one
-				if (lastActiveInteractableActor)
-				{
-					Cast<IInteractable>(lastActiveInteractableActor)->Execute_SetInteractableActive(
-						lastActiveInteractableActor, false);
-				}
-
-				// enable the newly picked one
-				Cast<IInteractable>(activeInteractableActor)->Execute_SetInteractableActive(
-					activeInteractableActor, true);
-			}
-
-			ActiveAInteractable = activeInteractableActor;
-		}
-	}
+	Super::EndPlay(EndPlayReason);
 }
 
-void ACameleonPlayerController::AddInteractable(AActor* aInteractable)
-{
-	if (aInteractable->Implements<UInteractable>() &&
-		Cast<IInteractable>(aInteractable)->Execute_IsUseable(aInteractable))
-	{
-		Interactables.Add(aInteractable);
-	}
-}
-
-void ACameleonPlayerController::RemoveInteractable(AActor* aInteractable)
-{
-	if (aInteractable == ActiveAInteractable)
-	{
-		ActiveAInteractable = nullptr;
-	}
-	Cast<IInteractable>(aInteractable)->Execute_SetInteractableActive(aInteractable, false);
-	Interactables.Remove(aInteractable);
-}
-
-void ACameleonPlayerController::SetNextAsActive()
+void ACameleonPlayerController::SetupInputComponent()
 {
-	if (bInTransition || ActiveCharacterIndex < 0)
-	{
-		return;
-	}
-
-	(*ControllableCharacters.Find(CharactersInSight[ActiveCharacterIndex]))->SetActive(false);
+	Super::SetupInputComponent();
+	check(InputComponent);
 
-	if (++ActiveCharacterIndex >= CharactersInSight.Num())
-	{
-		ActiveCharacterIndex = 0;
-	}
+	// The actions go through the session recording, the character binds the rest of the inputs
 
-	(*ControllableCharacters.Find(CharactersInSight[ActiveCharacterIndex]))->SetActive(true);
+	InputComponent->BindAction<FSessionActionDelegate>("NextCharacter", IE_Pressed, this, &ACameleonPlayerController::OnSessionActionPressed, ECameleonSessionAction::NextCharacter);
+	InputComponent->BindAction<FSessionActionDelegate>("PreviousCharacter", IE_Pressed, this, &ACameleonPlayerController::OnSessionActionPressed, ECameleonSessionAction::PreviousCharacter);
+	InputComponent->BindAction<FSessionActionDelegate>("SwitchCharacter", IE_Pressed, this, &ACameleonPlayerController::OnSessionActionPressed, ECameleonSessionAction::SwitchCharacter);
+	InputComponent->BindAction<FSessionActionDelegate>("UseInteractable", IE_Pressed, this, &ACameleonPlayerController::OnSessionActionPressed, ECameleonSessionAction::UseInteractable);
+	InputComponent->BindAction<FSessionActionDelegate>("ToggleScan", IE_Pressed, this, &ACameleonPlayerController::OnSessionActionPressed, ECameleonSessionAction::ToggleScan);
 }
 
-void ACameleonPlayerController::SetPreviousAsActive()
+void ACameleonPlayerController::PostProcessInput(const float DeltaTime, const bool bGamePaused)
 {
-	if (bInTransition || ActiveCharacterIndex < 0)
-	{
-		return;
-	}
+	Super::PostProcessInput(DeltaTime, bGamePaused);
 
-	(*ControllableCharacters.Find(CharactersInSight[ActiveCharacterIndex]))->SetActive(false);
-
-	if (--ActiveCharacterIndex < 0)
+	if (auto sessionSubsystem = GetWorld()->GetSubsystem<UCameleonSessionSubsystem>())
 	{
-		ActiveCharacterIndex = CharactersInSight.Num() - 1;
+		sessionSubsystem->OnInputProcessed(this);
 	}
-
-	(*ControllableCharacters.Find(CharactersInSight[ActiveCharacterIndex]))->SetActive(true);
 }
 
-void ACameleonPlayerController::SwitchCharacter()
+void ACameleonPlayerController::OnSessionActionPressed(const ECameleonSessionAction Action)
 {
-	if (bCanSwitch && ActiveCharacterIndex > -1)
+	if (auto sessionSubsystem = GetWorld()->GetSubsystem<UCameleonSessionSubsystem>())
 	{
-		const auto characterToUse = CharactersInSight[ActiveCharacterIndex];
-		// sanity check if characters is behind us
-
-		const auto playerLocation = GetCharacter()->GetActorLocation();
-		const auto characterLocation = characterToUse->GetActorLocation();
-		const auto toCharacterDir = (characterLocation - playerLocation).GetUnsafeNormal();
-		const auto dot = FVector::DotProduct(GetCharacter()->GetActorForwardVector(), toCharacterDir);
-
-		if (dot < 0)
+		if (sessionSubsystem->IsReplaying())
 		{
-			// character is behin
 			return;
 		}
 
-		// check if something is not in the way
-
-		if (!CanWeSee(characterToUse))
-		{
-			return;
-		}
-
-		auto mesh = characterToUse->GetMesh();
-		auto camera = characterToUse->FindComponentByClass<UCameraComponent>();
-
-		if (mesh && camera)
-		{
-			DisableInput(this);
-			UnPossess();
-
-			bCanSwitch = false;
-			bInTransition = true;
-			TransitionTimer = 0;
-
-			CollisionComponent->AttachToComponent(camera, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
-			CollisionComponent->SetGenerateOverlapEvents(false);
-
-			SetViewTargetWithBlend(characterToUse, TransitionTimeSeconds);
-			CurrentCharacterCamera = camera;
-		}
+		sessionSubsystem->RecordAction(Action);
 	}
-}
 
-void ACameleonPlayerController::UseInteractable()
-{
-	if (ActiveAInteractable)
-	{
-		auto interactable = Cast<IInteractable>(ActiveAInteractable);
-		interactable->Execute_Interact(ActiveAInteractable);
-
-		// Remove the interactable if it can't be used anymore
-		if (!interactable->Execute_IsUseable(ActiveAInteractable))
-		{
-			interactable->Execute_SetInteractableActive(ActiveAInteractable, false);
-			Interactables.Remove(ActiveAInteractable);
-			ActiveAInteractable = nullptr;
-		}
-	}
-}
-
-void ACameleonPlayerController::ToggleScanAbility()
-{
-	// Don't allow to toggle the ability while in transition
-	if (bInTransition)
-	{
-		return;
-	}
-
-	// Reset the ability if it's currently active
-	if (CollisionComponent->GetGenerateOverlapEvents())
-	{
-		bCanSwitch = false;
-		//@TODO Remove once we have some nice effect to show the scan region
-		CollisionComponent->SetHiddenInGame(true);
-		CollisionComponent->SetGenerateOverlapEvents(false);
-		ClearControllableCharacters();
-	}
-	else
-	{
-		bCanSwitch = true;
-		//@TODO Remove once we have some nice effect to show the scan region
-		CollisionComponent->SetHiddenInGame(false);
-		CollisionComponent->SetGenerateOverlapEvents(true);
-	}
+	DispatchSessionAction(Action);
 }
 
-void ACameleonPlayerController::OnActorBeginOverlap(UPrimitiveComponent* OverlappedComponent,
-                                                    AActor* OtherActor,
-                                                    UPrimitiveComponent* OtherComp,
-                                                    int32 OtherBodyIndex,
-                                                    bool bFromSweep,
-                                                    const FHitResult& SweepResult)
+void ACameleonPlayerController::DispatchSessionAction(const ECameleonSessionAction Action)
 {
-	// Ignore overlaps when changing characters
-
-	if (bInTransition)
-	{
-		return;
-	}
-	auto overlappedCharacter = Cast<ACameleonGameCharacter>(OtherActor);
-
-	if (!overlappedCharacter)
-	{
-		return;
-	}
-
-	//sanity check
-
-	if (overlappedCharacter == GetCharacter())
-	{
-		return;
-	}
-
-	FGameplayTagContainer characterTags;
-	overlappedCharacter->GetOwnedGameplayTags(characterTags);
-	if (!CanWeSee(overlappedCharacter) || !ControllableCharacterQuery.Matches(characterTags))
-	{
-		return;
-	}
-
-	auto mesh = overlappedCharacter->GetMesh();
-	auto capsule = overlappedCharacter->GetCapsuleComponent();
-
-	if (mesh && capsule)
+	switch (Action)
 	{
-		// Calculate the offset from the character's head at which we'll place the marker //
-
-		float radius, halfHeight;
-		capsule->GetScaledCapsuleSize(radius, halfHeight);
-
-		float aboveActorHead = halfHeight + 10;
-
-		// Spawn the marker //
-
-		auto marker = GetWorld()->SpawnActor<AControllableCharacterMarker>(
-			MarkerClass,
-			overlappedCharacter->GetActorLocation() + FVector{0, 0, aboveActorHead},
-			FRotator::ZeroRotator
-		);
+	case ECameleonSessionAction::NextCharacter:
+		SwitchCharacterComponent->SetNextAsActive();
+		break;
 
-		marker->AttachToActor(overlappedCharacter, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
-		marker->SetActorRelativeLocation({0, 0, aboveActorHead});
-		marker->SetActive(false);
+	case ECameleonSessionAction::PreviousCharacter:
+		SwitchCharacterComponent->SetPreviousAsActive();
+		break;
 
-		ControllableCharacters.Add(overlappedCharacter, marker);
+	case ECameleonSessionAction::SwitchCharacter:
+		SwitchCharacterComponent->SwitchCharacter();
+		break;
 
-		// Add the actor to the array holding actors in our sight so we can switch if there are multiple 
-		// The array holds the character in order from the closest to the one most far away, so we need
-		// to find a place for the newly overlapped character
+	case ECameleonSessionAction::UseInteractable:
+		SwitchCharacterComponent->UseInteractable();
+		break;
 
-		float distanceToOverlappedCharacter = (overlappedCharacter->GetActorLocation() - GetCharacter()->
-			GetActorLocation()).Size();
+	case ECameleonSessionAction::ToggleScan:
+		SwitchCharacterComponent->ToggleScanAbility();
+		break;
 
-		int overlappedCharacterIndex = -1;
-		for (int characterIdx = 0; characterIdx < CharactersInSight.Num(); ++characterIdx)
+	case ECameleonSessionAction::Jump:
+		if (auto character = Cast<ACharacter>(GetPawn()))
 		{
-			float distToCharacter = (CharactersInSight[characterIdx]->GetActorLocation() - GetCharacter()->
-				GetActorLocation()).Size();
-			if (distToCharacter > distanceToOverlappedCharacter)
-			{
-				overlappedCharacterIndex = characterIdx;
-				CharactersInSight.EmplaceAt(overlappedCharacterIndex, overlappedCharacter);
-				if (overlappedCharacterIndex == ActiveCharacterIndex)
-				{
-					++ActiveCharacterIndex;
-				}
-
-				break;
-			}
+			character->Jump();
 		}
+		break;
 
-		// This is the case when there are no characters in sight
-		// or the new character is behind all of the currently in sight characters
-
-		if (overlappedCharacterIndex == -1)
-		{
-			CharactersInSight.Add(overlappedCharacter);
-
-			// Make the character active if it is the only one
-			if (ActiveCharacterIndex < 0)
-			{
-				ActiveCharacterIndex = 0;
-				marker->SetActive(true);
-			}
-		}
+	default:
+		break;
 	}
 }
 
-void ACameleonPlayerController::OnActorEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
-                                                  UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void ACameleonPlayerController::OnPossess(APawn* aPawn)
 {
-	// Ignore overlaps in collision
-
-	if (bInTransition)
-	{
-		return;
-	}
-
-	if (auto character = Cast<ACameleonGameCharacter>(OtherActor)) // make sure the overlapped actor is a character
-	{
-		// Sanity check
-		if (character == GetCharacter())
-		{
-			return;
-		}
-
-		// Get a marker for the overlapped character to Destroy() it
-		auto marker = ControllableCharacters.Find(character);
-		if (marker)
-		{
-			// Find the index of the overlapped character and remove it //
-
-			int removedCharacterIndex = CharactersInSight.IndexOfByPredicate([character](ACharacter* It)
-			{
-				return character == It;
-			});
-
-			CharactersInSight.RemoveAt(removedCharacterIndex);
+	Super::OnPossess(aPawn);
 
-			// Adjust the active character index if the character that we've lost sight of
-			// was closer to us than the active character
-			if (ActiveCharacterIndex > removedCharacterIndex)
-			{
-				--ActiveCharacterIndex;
-			}
-			else if (removedCharacterIndex == ActiveCharacterIndex)
-			{
-				// if the removed character was active and if yes, then mark next as active
-
-				if (ActiveCharacterIndex >= CharactersInSight.Num())
-				{
-					--ActiveCharacterIndex;
-				}
-				if (ActiveCharacterIndex > -1)
-				{
-					(*ControllableCharacters.Find(CharactersInSight[ActiveCharacterIndex]))->SetActive(true);
-				}
-			}
-
-			(*marker)->Destroy();
-			ControllableCharacters.Remove(character);
-		}
-	}
+	SwitchCharacterComponent->AttachToPossessedCharacter();
 }
 
-void ACameleonPlayerController::ClearControllableCharacters()
+void ACameleonPlayerController::AcknowledgePossession(APawn* P)
 {
-	// Destroy all of the markers
+	Super::AcknowledgePossession(P);
 
-	for (auto it = ControllableCharacters.CreateIterator(); it; ++it)
-	{
-		it.Value()->Destroy();
-	}
+	// The possession by the server has replicated to the owning client
+	SwitchCharacterComponent->AttachToPossessedCharacter();
+}
 
-	ControllableCharacters.Empty();
-	CharactersInSight.Empty();
-	ActiveCharacterIndex = -1;
+FControllableCharacterMarkerPoolStats ACameleonPlayerController::GetMarkerPoolStats() const
+{
+	return SwitchCharacterComponent->GetMarkerPoolStats();
 }
 
-bool ACameleonPlayerController::CanWeSee(const ACharacter* OtherCharacter) const
+void ACameleonPlayerController::AddInteractable(AActor* aInteractable)
 {
-	FHitResult hitResult;
-	GetWorld()->LineTraceSingleByChannel(hitResult,
-	                                     CurrentCharacterCamera->GetComponentLocation() +
-	                                     CurrentCharacterCamera->GetForwardVector() * 100,
-	                                     OtherCharacter->GetActorLocation(), ECC_Camera);
+}
 
-	return OtherCharacter == hitResult.Actor;
+void ACameleonPlayerController::RemoveInteractable(AActor* aInteractable)
+{
+	// A player leaving the interactable would take it away from every other player
 }
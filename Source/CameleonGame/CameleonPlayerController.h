@@ -5,7 +5,8 @@
 #include "CoreMinimal.h"
 
 #include "GameFramework/PlayerController.h"
-#include "GameplayTagContainer.h"
+#include "ControllableCharacterMarkerPool.h"
+#include "CameleonSessionRecording.h"
 #include "CameleonPlayerController.generated.h"
 
 UCLASS()
@@ -16,105 +17,53 @@ public:
 
 	ACameleonPlayerController();
 
-	// Actor to spawn as controllable character marker //
+	// Actor to spawn as controllable character marker, passed to the switch character component //
 	UPROPERTY(EditDefaultsOnly)
 	TSubclassOf<class AControllableCharacterMarker> MarkerClass;
 
+	// Passed to the switch character component //
 	UPROPERTY(EditDefaultsOnly)
 	float TransitionTimeSeconds = 1.5;
 
-	UFUNCTION(BlueprintCallable)
-	void AddInteractable(AActor* aInteractable);
-
-	UFUNCTION(BlueprintCallable)
-	void RemoveInteractable(AActor* aInteractable);
-
-protected:
-	virtual void SetupInputComponent() override;
-	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaSeconds) override;
-
-	// Input handling
+	UFUNCTION(BlueprintPure)
+	FControllableCharacterMarkerPoolStats GetMarkerPoolStats() const;
 
-	UFUNCTION()
-	void SetNextAsActive();
+	// The interactables are registered with UCameleonInteractableSubsystem automatically and the registry is //
+	// shared by all of the players, so these do nothing. Kept for the Blueprints which still call them //
 
-	UFUNCTION()
-	void SetPreviousAsActive();
-
-	UFUNCTION()
-	void SwitchCharacter();
+	UFUNCTION(BlueprintCallable, meta = (DeprecatedFunction, DeprecationMessage = "The interactables are registered automatically"))
+	void AddInteractable(AActor* aInteractable);
 
-	UFUNCTION()
-	void UseInteractable();
+	UFUNCTION(BlueprintCallable, meta = (DeprecatedFunction, DeprecationMessage = "The interactables are registered automatically"))
+	void RemoveInteractable(AActor* aInteractable);
 
-	UFUNCTION()
-	void ToggleScanAbility();
+	FORCEINLINE class USwitchCharacterComponent* GetSwitchCharacterComponent() const
+	{
+		return SwitchCharacterComponent;
+	}
 
-	// Scan component overlap handlers
+	// Performs the action bound to the input, used by the session replay as well //
+	void DispatchSessionAction(ECameleonSessionAction Action);
 
-	UFUNCTION()
-	void OnActorBeginOverlap(UPrimitiveComponent* OverlappedComponent,
-	                         AActor* OtherActor,
-	                         UPrimitiveComponent* OtherComp,
-	                         int32 OtherBodyIndex,
-	                         bool bFromSweep,
-	                         const FHitResult& SweepResult);
+protected:
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void SetupInputComponent() override;
+	virtual void PostProcessInput(float DeltaTime, bool bGamePaused) override;
+	virtual void OnPossess(APawn* aPawn) override;
 
-	UFUNCTION()
-	void OnActorEndOverlap(UPrimitiveComponent* OverlappedComponent,
-	                       AActor* OtherActor,
-	                       UPrimitiveComponent* OtherComp,
-	                       int32 OtherBodyIndex);
+public:
+	virtual void AcknowledgePossession(APawn* P) override;
 
 private:
-	// Clears the list of characters in sight that we can take control over, removes their markers //
-	void ClearControllableCharacters();
-
-	// Checks if we can see the character, i.e. if it's not blocked by some geometry
-	bool CanWeSee(const ACharacter* OtherCharacter) const;
-
-	// Maximal distance at which we can take control over a character //
-
-	UPROPERTY()
-	FVector ScanDistance = {2500, 1000, 350};
-
-	// Map which holds controllable character in player's sight along with their markers //
-
-	UPROPERTY()
-	TMap<class ACameleonGameCharacter*, class AControllableCharacterMarker*> ControllableCharacters;
-
-	// Box used to determine what is in players view frustum and this what can he take control over //
-
-	UPROPERTY()
-	class UBoxComponent* CollisionComponent;
-
-	UPROPERTY()
-	int ActiveCharacterIndex = -1;
-
-	UPROPERTY()
-    TArray<class ACameleonGameCharacter*> CharactersInSight;
-
-	// Flag indicating if we can use the switch ability //
-
-	UPROPERTY()
-	bool bCanSwitch;
-
-	UPROPERTY()
-	bool bInTransition;
-
-	UPROPERTY()
-	float TransitionTimer;
-
-	UPROPERTY()
-	class UCameraComponent* CurrentCharacterCamera;
+	DECLARE_DELEGATE_OneParam(FSessionActionDelegate, ECameleonSessionAction);
 
-	UPROPERTY()
-	TArray<AActor*> Interactables;
+	// Records the pressed action if the session is being recorded, the live input is ignored during a replay //
+	void OnSessionActionPressed(ECameleonSessionAction Action);
 
-	UPROPERTY()
-	class AActor* ActiveAInteractable;
+	// Implements the switch ability, scanning, focusing interactables and the transitions between characters //
 
-	UPROPERTY()
-    FGameplayTagQuery ControllableCharacterQuery;
+	UPROPERTY(VisibleAnywhere, meta = (AllowPrivateAccess = "true"))
+	class USwitchCharacterComponent* SwitchCharacterComponent;
 };
@@ -0,0 +1,53 @@
+#include "CameleonProfiling.h"
+
+DEFINE_STAT(STAT_Cameleon_Tick);
+DEFINE_STAT(STAT_Cameleon_ScanVolume);
+DEFINE_STAT(STAT_Cameleon_CharacterEnteredScan);
+DEFINE_STAT(STAT_Cameleon_CharacterLeftScan);
+DEFINE_STAT(STAT_Cameleon_CanWeSee);
+DEFINE_STAT(STAT_Cameleon_RankCandidates);
+DEFINE_STAT(STAT_Cameleon_InteractableFocus);
+DEFINE_STAT(STAT_Cameleon_SwitchCharacter);
+DEFINE_STAT(STAT_Cameleon_ClearControllableCharacters);
+
+DEFINE_STAT(STAT_Cameleon_CandidatesInSight);
+DEFINE_STAT(STAT_Cameleon_LiveMarkers);
+DEFINE_STAT(STAT_Cameleon_VisibilityTraces);
+DEFINE_STAT(STAT_Cameleon_InteractablesTracked);
+
+DEFINE_STAT(STAT_Cameleon_SwitchLatency);
+
+CSV_DEFINE_CATEGORY_MODULE(CAMELEONGAME_API, Cameleon, true);
+
+FCameleonFrameProfile& FCameleonFrameProfile::Get()
+{
+	static FCameleonFrameProfile profile;
+	return profile;
+}
+
+const TCHAR* FCameleonFrameProfile::GetSectionName(const ECameleonProfileSection Section)
+{
+	switch (Section)
+	{
+	case ECameleonProfileSection::Tick:
+		return TEXT("Tick");
+	case ECameleonProfileSection::ScanVolume:
+		return TEXT("ScanVolume");
+	case ECameleonProfileSection::CharacterEnteredScan:
+		return TEXT("CharacterEnteredScan");
+	case ECameleonProfileSection::CharacterLeftScan:
+		return TEXT("CharacterLeftScan");
+	case ECameleonProfileSection::CanWeSee:
+		return TEXT("CanWeSee");
+	case ECameleonProfileSection::RankCandidates:
+		return TEXT("RankCandidates");
+	case ECameleonProfileSection::InteractableFocus:
+		return TEXT("InteractableFocus");
+	case ECameleonProfileSection::SwitchCharacter:
+		return TEXT("SwitchCharacter");
+	case ECameleonProfileSection::ClearControllableCharacters:
+		return TEXT("ClearControllableCharacters");
+	default:
+		return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// Hot paths of the switch ability, each profiled section has a cycle stat named STAT_Cameleon_<Section> //
+// and a CSV timing stat of the same name in the Cameleon category //
+
+DECLARE_STATS_GROUP(TEXT("Cameleon"), STATGROUP_Cameleon, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Switch Tick"), STAT_Cameleon_Tick, STATGROUP_Cameleon, CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scan Volume Query"), STAT_Cameleon_ScanVolume, STATGROUP_Cameleon, CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Entered Scan"), STAT_Cameleon_CharacterEnteredScan, STATGROUP_Cameleon,
+                          CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Left Scan"), STAT_Cameleon_CharacterLeftScan, STATGROUP_Cameleon,
+                          CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Can We See"), STAT_Cameleon_CanWeSee, STATGROUP_Cameleon, CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Rank Candidates"), STAT_Cameleon_RankCandidates, STATGROUP_Cameleon, CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interactable Focus"), STAT_Cameleon_InteractableFocus, STATGROUP_Cameleon,
+                          CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Switch Character"), STAT_Cameleon_SwitchCharacter, STATGROUP_Cameleon, CAMELEONGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Clear Controllable Characters"), STAT_Cameleon_ClearControllableCharacters,
+                          STATGROUP_Cameleon, CAMELEONGAME_API);
+
+// Per-frame counters, summed over all of the switch components //
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Candidates In Sight"), STAT_Cameleon_CandidatesInSight, STATGROUP_Cameleon,
+                                  CAMELEONGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Live Markers"), STAT_Cameleon_LiveMarkers, STATGROUP_Cameleon, CAMELEONGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Visibility Traces"), STAT_Cameleon_VisibilityTraces, STATGROUP_Cameleon,
+                                  CAMELEONGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Interactables Tracked"), STAT_Cameleon_InteractablesTracked, STATGROUP_Cameleon,
+                                  CAMELEONGAME_API);
+
+// Time between the switch input and the start of the transition, of the last switch //
+
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Switch Latency (ms)"), STAT_Cameleon_SwitchLatency, STATGROUP_Cameleon,
+                                      CAMELEONGAME_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(CAMELEONGAME_API, Cameleon);
+
+// Sections of the switch ability whose cost is tracked per frame //
+enum class ECameleonProfileSection : uint8
+{
+	Tick,
+	ScanVolume,
+	CharacterEnteredScan,
+	CharacterLeftScan,
+	CanWeSee,
+	RankCandidates,
+	InteractableFocus,
+	SwitchCharacter,
+	ClearControllableCharacters,
+	Num
+};
+
+// Accumulates the time spent in each of the sections during the current frame, game thread only. //
+// Disabled by default, enabled by the benchmarks which read and reset it every frame //
+class CAMELEONGAME_API FCameleonFrameProfile
+{
+public:
+	static FCameleonFrameProfile& Get();
+
+	static const TCHAR* GetSectionName(ECameleonProfileSection Section);
+
+	bool IsEnabled() const
+	{
+		return bEnabled;
+	}
+
+	void SetEnabled(const bool bInEnabled)
+	{
+		bEnabled = bInEnabled;
+		Reset();
+	}
+
+	void Add(const ECameleonProfileSection Section, const uint64 InCycles)
+	{
+		Cycles[static_cast<uint8>(Section)] += InCycles;
+		++Calls[static_cast<uint8>(Section)];
+	}
+
+	double GetMilliseconds(const ECameleonProfileSection Section) const
+	{
+		return FPlatformTime::ToMilliseconds64(Cycles[static_cast<uint8>(Section)]);
+	}
+
+	uint32 GetCalls(const ECameleonProfileSection Section) const
+	{
+		return Calls[static_cast<uint8>(Section)];
+	}
+
+	void Reset()
+	{
+		FMemory::Memzero(Cycles);
+		FMemory::Memzero(Calls);
+	}
+
+private:
+	bool bEnabled = false;
+
+	uint64 Cycles[static_cast<uint8>(ECameleonProfileSection::Num)] = {};
+
+	uint32 Calls[static_cast<uint8>(ECameleonProfileSection::Num)] = {};
+};
+
+class FCameleonScopedProfile
+{
+public:
+	explicit FCameleonScopedProfile(const ECameleonProfileSection InSection)
+		: Section(InSection),
+		  StartCycles(FCameleonFrameProfile::Get().IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FCameleonScopedProfile()
+	{
+		if (StartCycles != 0)
+		{
+			FCameleonFrameProfile::Get().Add(Section, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	ECameleonProfileSection Section;
+	uint64 StartCycles;
+};
+
+// Times the rest of the scope with the cycle stat, the CSV profiler and the frame profile //
+#define CAMELEON_PROFILE_SCOPE(Section) \
+	SCOPE_CYCLE_COUNTER(STAT_Cameleon_##Section); \
+	CSV_SCOPED_TIMING_STAT(Cameleon, Section); \
+	FCameleonScopedProfile ANONYMOUS_VARIABLE(CameleonProfileScope)(ECameleonProfileSection::Section)
@@ -0,0 +1,271 @@
+#include "CameleonProjectileSubsystem.h"
+#include "CameleonGameProjectile.h"
+#include "CameleonProfiling.h"
+#include "Async/ParallelFor.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectiles"), STAT_Cameleon_Projectiles, STATGROUP_Cameleon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Projectiles"), STAT_Cameleon_LiveProjectiles, STATGROUP_Cameleon);
+
+void UCameleonProjectileSubsystem::Deinitialize()
+{
+	Positions.Empty();
+	PreviousPositions.Empty();
+	Velocities.Empty();
+	RemainingLifetimes.Empty();
+	SweepHandles.Empty();
+	Instigators.Empty();
+	VisualActors.Empty();
+	FreeVisualActors.Empty();
+	NumVisualActors = 0;
+
+	Super::Deinitialize();
+}
+
+void UCameleonProjectileSubsystem::FireProjectile(const FVector Location, const FVector Velocity, AActor* Instigator)
+{
+	Positions.Add(Location);
+	PreviousPositions.Add(Location);
+	Velocities.Add(Velocity);
+	RemainingLifetimes.Add(Lifetime);
+	SweepHandles.Add(FTraceHandle());
+	Instigators.Add(Instigator);
+
+	auto visualActor = AcquireVisualActor();
+	if (visualActor)
+	{
+		visualActor->SetActorLocationAndRotation(Location, Velocity.Rotation());
+	}
+	VisualActors.Add(visualActor);
+}
+
+void UCameleonProjectileSubsystem::PrewarmVisualActors(const int32 NumActors)
+{
+	TArray<ACameleonGameProjectile*> visualActors;
+	for (int32 actorIdx = 0; actorIdx < NumActors; ++actorIdx)
+	{
+		if (const auto visualActor = AcquireVisualActor())
+		{
+			visualActors.Add(visualActor);
+		}
+	}
+
+	for (auto visualActor : visualActors)
+	{
+		ReleaseVisualActor(visualActor);
+	}
+}
+
+void UCameleonProjectileSubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Cameleon_Projectiles);
+
+	ResolveSweeps();
+	Integrate(DeltaTime);
+	DispatchSweeps();
+	UpdateVisualActors();
+
+	SET_DWORD_STAT(STAT_Cameleon_LiveProjectiles, Positions.Num());
+
+	// Broadcast last, the listeners might fire new projectiles
+
+	for (int32 hitIdx = 0; hitIdx < PendingHits.Num(); ++hitIdx)
+	{
+		OnProjectileHit.Broadcast(PendingHits[hitIdx], PendingHitInstigators[hitIdx]);
+	}
+
+	PendingHits.Reset();
+	PendingHitInstigators.Reset();
+}
+
+void UCameleonProjectileSubsystem::ResolveSweeps()
+{
+	const auto world = GetWorld();
+
+	// Backwards since the removal swaps the last projectile in
+
+	for (int32 projectileIdx = Positions.Num() - 1; projectileIdx >= 0; --projectileIdx)
+	{
+		FTraceDatum sweepData;
+		if (SweepHandles[projectileIdx].IsValid() && world->QueryTraceData(SweepHandles[projectileIdx], sweepData))
+		{
+			const auto hit = sweepData.OutHits.FindByPredicate([](const FHitResult& Hit)
+			{
+				return Hit.bBlockingHit;
+			});
+
+			if (hit)
+			{
+				if (auto hitComponent = hit->GetComponent())
+				{
+					if (hitComponent->IsSimulatingPhysics())
+					{
+						hitComponent->AddImpulseAtLocation(Velocities[projectileIdx] * ImpulseScale, hit->ImpactPoint);
+					}
+				}
+
+				PendingHits.Add(*hit);
+				PendingHitInstigators.Add(Instigators[projectileIdx]);
+				RemoveProjectile(projectileIdx);
+				continue;
+			}
+		}
+
+		if (RemainingLifetimes[projectileIdx] <= 0.f)
+		{
+			RemoveProjectile(projectileIdx);
+		}
+	}
+}
+
+void UCameleonProjectileSubsystem::Integrate(const float DeltaTime)
+{
+	const auto gravity = FVector(0.f, 0.f, GetWorld()->GetGravityZ() * GravityScale);
+	const auto halfGravityDeltaTimeSquared = gravity * (0.5f * DeltaTime * DeltaTime);
+	const auto gravityDeltaTime = gravity * DeltaTime;
+
+	// Every projectile only touches its own elements
+	ParallelFor(Positions.Num(), [&](const int32 ProjectileIdx)
+	{
+		PreviousPositions[ProjectileIdx] = Positions[ProjectileIdx];
+		Positions[ProjectileIdx] += Velocities[ProjectileIdx] * DeltaTime + halfGravityDeltaTimeSquared;
+		Velocities[ProjectileIdx] += gravityDeltaTime;
+		RemainingLifetimes[ProjectileIdx] -= DeltaTime;
+	}, Positions.Num() < MinParallelProjectiles);
+}
+
+void UCameleonProjectileSubsystem::DispatchSweeps()
+{
+	const auto world = GetWorld();
+	const auto sphere = FCollisionShape::MakeSphere(Radius);
+
+	for (int32 projectileIdx = 0; projectileIdx < Positions.Num(); ++projectileIdx)
+	{
+		FCollisionQueryParams queryParams(SCENE_QUERY_STAT(CameleonProjectile), false, Instigators[projectileIdx]);
+
+		SweepHandles[projectileIdx] = world->AsyncSweepByChannel(EAsyncTraceType::Single,
+		                                                         PreviousPositions[projectileIdx],
+		                                                         Positions[projectileIdx],
+		                                                         FQuat::Identity,
+		                                                         CollisionChannel,
+		                                                         sphere,
+		                                                         queryParams);
+	}
+}
+
+void UCameleonProjectileSubsystem::UpdateVisualActors()
+{
+	for (int32 projectileIdx = 0; projectileIdx < Positions.Num(); ++projectileIdx)
+	{
+		const auto visualActor = VisualActors[projectileIdx];
+		if (IsValid(visualActor))
+		{
+			visualActor->SetActorLocationAndRotation(Positions[projectileIdx], Velocities[projectileIdx].Rotation());
+		}
+	}
+}
+
+void UCameleonProjectileSubsystem::RemoveProjectile(const int32 Index)
+{
+	if (VisualActors[Index])
+	{
+		ReleaseVisualActor(VisualActors[Index]);
+	}
+
+	Positions.RemoveAtSwap(Index, 1, false);
+	PreviousPositions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	RemainingLifetimes.RemoveAtSwap(Index, 1, false);
+	SweepHandles.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	VisualActors.RemoveAtSwap(Index, 1, false);
+}
+
+ACameleonGameProjectile* UCameleonProjectileSubsystem::AcquireVisualActor()
+{
+	// Skip the actors that got destroyed behind our back, e.g. when the level was unloaded, they don't count
+	// towards the cap anymore
+	while (FreeVisualActors.Num() > 0)
+	{
+		auto visualActor = FreeVisualActors.Pop(false);
+		if (IsValid(visualActor))
+		{
+			visualActor->SetActorHiddenInGame(false);
+			return visualActor;
+		}
+
+		--NumVisualActors;
+	}
+
+	// The in-flight actors destroyed meanwhile have been nulled by the garbage collector, count the live ones
+	// again before giving up
+	if (NumVisualActors >= MaxVisualActors)
+	{
+		NumVisualActors = 0;
+		for (const auto visualActor : VisualActors)
+		{
+			NumVisualActors += IsValid(visualActor) ? 1 : 0;
+		}
+	}
+
+	const auto visualActorClass = VisualActorClass.LoadSynchronous();
+	if (!visualActorClass || NumVisualActors >= MaxVisualActors)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParameters.ObjectFlags |= RF_Transient;
+
+	auto visualActor = GetWorld()->SpawnActor<ACameleonGameProjectile>(visualActorClass, FTransform::Identity,
+	                                                                   spawnParameters);
+	if (visualActor)
+	{
+		// The sweeps do the collision and the subsystem the movement
+		visualActor->SetActorEnableCollision(false);
+		visualActor->SetActorTickEnabled(false);
+
+		for (auto component : visualActor->GetComponents())
+		{
+			component->SetComponentTickEnabled(false);
+		}
+		++NumVisualActors;
+	}
+
+	return visualActor;
+}
+
+void UCameleonProjectileSubsystem::ReleaseVisualActor(ACameleonGameProjectile* VisualActor)
+{
+	if (!IsValid(VisualActor))
+	{
+		--NumVisualActors;
+		return;
+	}
+
+	VisualActor->SetActorHiddenInGame(true);
+	FreeVisualActors.Add(VisualActor);
+}
+
+bool UCameleonProjectileSubsystem::IsTickable() const
+{
+	return Positions.Num() > 0 || PendingHits.Num() > 0;
+}
+
+ETickableTickType UCameleonProjectileSubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonProjectileSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonProjectileSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
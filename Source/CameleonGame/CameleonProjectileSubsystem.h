@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "CameleonProjectileSubsystem.generated.h"
+
+class ACameleonGameProjectile;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FCameleonProjectileHitSignature, const FHitResult&, Hit, AActor*, Instigator);
+
+// Simulates all of the projectiles of the world in one batch per frame. Their state is kept in contiguous //
+// arrays and advanced in parallel once there are enough of them, the collisions are resolved by async sweeps //
+// which the engine runs in batches. The projectiles have no actors of their own, pooled ACameleonGameProjectile //
+// actors are attached to them only to render them //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonProjectileSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Fires a projectile, it never hits the instigator //
+	UFUNCTION(BlueprintCallable)
+	void FireProjectile(FVector Location, FVector Velocity, AActor* Instigator);
+
+	// Spawns the visual actors upfront so firing doesn't have to //
+	void PrewarmVisualActors(int32 NumActors);
+
+	int32 GetNumProjectiles() const
+	{
+		return Positions.Num();
+	}
+
+	UPROPERTY(BlueprintAssignable)
+	FCameleonProjectileHitSignature OnProjectileHit;
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	// Removes the projectiles whose sweeps from the last frame have hit something, returns their hits //
+	void ResolveSweeps();
+
+	// Advances the positions, velocities and lifetimes of all of the projectiles //
+	void Integrate(float DeltaTime);
+
+	// Sweeps every projectile from its last position to the new one //
+	void DispatchSweeps();
+
+	void UpdateVisualActors();
+
+	void RemoveProjectile(int32 Index);
+
+	ACameleonGameProjectile* AcquireVisualActor();
+
+	void ReleaseVisualActor(ACameleonGameProjectile* VisualActor);
+
+	// Actor rendering the projectiles, no visuals if it's not set //
+	UPROPERTY(Config)
+	TSoftClassPtr<ACameleonGameProjectile> VisualActorClass;
+
+	// Projectiles beyond this count have no visual actor //
+	UPROPERTY(Config)
+	int32 MaxVisualActors = 256;
+
+	UPROPERTY(Config)
+	float Radius = 5.f;
+
+	// Seconds after which the projectiles which haven't hit anything disappear //
+	UPROPERTY(Config)
+	float Lifetime = 3.f;
+
+	UPROPERTY(Config)
+	float GravityScale = 1.f;
+
+	// Impulse applied to the simulating components which are hit, relative to the projectile's velocity //
+	UPROPERTY(Config)
+	float ImpulseScale = 100.f;
+
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> CollisionChannel = ECC_WorldDynamic;
+
+	// Smallest number of projectiles that is advanced in parallel //
+	UPROPERTY(Config)
+	int32 MinParallelProjectiles = 256;
+
+	// Projectile state, one element per live projectile //
+
+	TArray<FVector> Positions;
+
+	TArray<FVector> PreviousPositions;
+
+	TArray<FVector> Velocities;
+
+	TArray<float> RemainingLifetimes;
+
+	// Sweep from the previous position to the current one, resolved on the next tick //
+	TArray<FTraceHandle> SweepHandles;
+
+	UPROPERTY()
+	TArray<AActor*> Instigators;
+
+	// Null for the projectiles without visuals //
+	UPROPERTY()
+	TArray<ACameleonGameProjectile*> VisualActors;
+
+	UPROPERTY()
+	TArray<ACameleonGameProjectile*> FreeVisualActors;
+
+	int32 NumVisualActors = 0;
+
+	// Hits of the current tick along with their instigators, broadcast once the projectiles are removed //
+
+	TArray<FHitResult> PendingHits;
+
+	UPROPERTY()
+	TArray<AActor*> PendingHitInstigators;
+};
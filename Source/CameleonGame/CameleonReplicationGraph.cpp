@@ -0,0 +1,227 @@
+#include "CameleonReplicationGraph.h"
+#include "CameleonGameCharacter.h"
+#include "CameleonProfiling.h"
+#include "CameleonScanSubsystem.h"
+#include "SwitchCharacterComponent.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Replication Gather"), STAT_Cameleon_ReplicationGather, STATGROUP_Cameleon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Near Replicated Characters"), STAT_Cameleon_NearReplicatedCharacters, STATGROUP_Cameleon);
+
+// UReplicationGraphNode_CameleonScan
+
+void UReplicationGraphNode_CameleonScan::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (auto character = Cast<ACameleonGameCharacter>(ActorInfo.Actor))
+	{
+		Characters.AddUnique(character);
+	}
+}
+
+bool UReplicationGraphNode_CameleonScan::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo,
+                                                                  const bool bWarnIfNotFound)
+{
+	const bool bRemoved = Characters.RemoveSingleSwap(Cast<ACameleonGameCharacter>(ActorInfo.Actor), false) > 0;
+
+	if (!bRemoved && bWarnIfNotFound)
+	{
+		UE_LOG(LogReplicationGraph, Warning, TEXT("UReplicationGraphNode_CameleonScan: %s not found"),
+		       *GetNameSafe(ActorInfo.Actor));
+	}
+
+	return bRemoved;
+}
+
+void UReplicationGraphNode_CameleonScan::NotifyResetAllNetworkActors()
+{
+	Characters.Reset();
+}
+
+void UReplicationGraphNode_CameleonScan::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Cameleon_ReplicationGather);
+
+	NearList.Reset();
+	FarList.Reset();
+
+	const auto world = GraphGlobals.IsValid() ? GraphGlobals->World : nullptr;
+	const auto scanSubsystem = world ? world->GetSubsystem<UCameleonScanSubsystem>() : nullptr;
+
+	// The possessed characters, the ones we're switching to and everything in the scan volumes every frame
+
+	for (const auto& viewer : Params.Viewers)
+	{
+		const auto playerController = Cast<APlayerController>(viewer.InViewer);
+		if (!playerController)
+		{
+			continue;
+		}
+
+		if (const auto pawn = playerController->GetPawn())
+		{
+			NearList.ConditionalAdd(pawn);
+		}
+
+		const auto switchComponent = playerController->FindComponentByClass<USwitchCharacterComponent>();
+		if (!switchComponent || !scanSubsystem)
+		{
+			continue;
+		}
+
+		if (const auto switchTarget = switchComponent->GetActiveCandidateCharacter())
+		{
+			NearList.ConditionalAdd(switchTarget);
+		}
+
+		// The server doesn't scan for the remote players, the volume is placed in front of their view point instead
+
+		const auto& scanDistance = switchComponent->GetScanDistance();
+		const FTransform viewTransform(viewer.ViewDir.Rotation(), viewer.ViewLocation);
+		const FTransform volumeTransform(viewTransform.GetRotation(),
+		                                 viewTransform.TransformPosition({scanDistance.X / 2, 0, scanDistance.Z / 2}));
+
+		scanSubsystem->QueryScanVolume(volumeTransform, scanDistance + FVector(ScanRelevancyMargin), CharactersInScan);
+
+		for (auto character : CharactersInScan)
+		{
+			NearList.ConditionalAdd(character);
+		}
+	}
+
+	// A slice of the rest of them within the far distance, the connections are spread over the frames as well
+	// so they don't all gather the same slice
+
+	const int32 period = FMath::Max(FarReplicationPeriod, 1);
+	const int32 firstIdx = (Params.ReplicationFrameNum + PointerHash(&Params.ConnectionManager)) % period;
+	const float farDistanceSquared = FMath::Square(FarReplicationDistance);
+
+	for (int32 characterIdx = firstIdx; characterIdx < Characters.Num(); characterIdx += period)
+	{
+		const auto character = Characters[characterIdx];
+		const auto location = character->GetActorLocation();
+
+		for (const auto& viewer : Params.Viewers)
+		{
+			if (FVector::DistSquared(location, viewer.ViewLocation) <= farDistanceSquared)
+			{
+				if (!NearList.Contains(character))
+				{
+					FarList.Add(character);
+				}
+				break;
+			}
+		}
+	}
+
+	if (NearList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(NearList);
+	}
+
+	if (FarList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(FarList);
+	}
+
+	INC_DWORD_STAT_BY(STAT_Cameleon_NearReplicatedCharacters, NearList.Num());
+}
+
+void UReplicationGraphNode_CameleonScan::GetAllActorsInNode_Debugging(TArray<FActorRepListType>& OutArray) const
+{
+	OutArray.Append(Characters);
+}
+
+// UCameleonReplicationGraph
+
+void UCameleonReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// By default the actors replicate at their NetUpdateFrequency and within their NetCullDistanceSquared
+
+	const auto actorCDO = GetDefault<AActor>();
+
+	FClassReplicationInfo actorInfo;
+	actorInfo.ReplicationPeriodFrame = FMath::Max(
+		FMath::RoundToInt(NetDriver->NetServerMaxTickRate / actorCDO->NetUpdateFrequency), 1);
+	actorInfo.SetCullDistanceSquared(actorCDO->NetCullDistanceSquared);
+	GlobalActorReplicationInfoMap.SetClassInfo(AActor::StaticClass(), actorInfo);
+
+	// The scan node decides when the characters replicate, they do whenever they're gathered. The far ones are
+	// gathered only once every FarReplicationPeriod frames, their channels have to stay open in between or
+	// the clients would destroy and spawn them again on every slice
+
+	FClassReplicationInfo characterInfo;
+	characterInfo.ReplicationPeriodFrame = 1;
+	characterInfo.ActorChannelFrameTimeout = static_cast<uint8>(
+		FMath::Clamp(FMath::Max(FarReplicationPeriod, 1) * 2, 4, static_cast<int32>(MAX_uint8)));
+	characterInfo.SetCullDistanceSquared(0.f);
+	GlobalActorReplicationInfoMap.SetClassInfo(ACameleonGameCharacter::StaticClass(), characterInfo);
+}
+
+void UCameleonReplicationGraph::InitGlobalGraphNodes()
+{
+	ScanNode = CreateNewNode<UReplicationGraphNode_CameleonScan>();
+	ScanNode->ScanRelevancyMargin = ScanRelevancyMargin;
+	ScanNode->FarReplicationDistance = FarReplicationDistance;
+	ScanNode->FarReplicationPeriod = FarReplicationPeriod;
+	AddGlobalGraphNode(ScanNode);
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UCameleonReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// The connection's player controller and view target
+	const auto alwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(alwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+void UCameleonReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo,
+                                                            FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const auto actor = ActorInfo.Actor;
+
+	if (actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+	}
+	else if (actor->IsA<ACameleonGameCharacter>())
+	{
+		ScanNode->NotifyAddNetworkActor(ActorInfo);
+	}
+	else if (!actor->bOnlyRelevantToOwner)
+	{
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+	}
+
+	// The actors only relevant to their owner are the player controllers, gathered by the connection's node
+}
+
+void UCameleonReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const auto actor = ActorInfo.Actor;
+
+	if (actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+	}
+	else if (actor->IsA<ACameleonGameCharacter>())
+	{
+		ScanNode->NotifyRemoveNetworkActor(ActorInfo);
+	}
+	else if (!actor->bOnlyRelevantToOwner)
+	{
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+	}
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "CameleonReplicationGraph.generated.h"
+
+class ACameleonGameCharacter;
+
+// Replicates the controllable characters based on the connection's scan volume: the ones inside of it (plus //
+// a margin), the possessed one and the one we're switching to every frame, the rest of them within //
+// FarReplicationDistance only every FarReplicationPeriod frames and nothing beyond that //
+UCLASS()
+class CAMELEONGAME_API UReplicationGraphNode_CameleonScan : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	virtual void GetAllActorsInNode_Debugging(TArray<FActorRepListType>& OutArray) const override;
+
+	// Extra distance around the scan volume, covers the characters walking into it before the next gather //
+	float ScanRelevancyMargin = 500.f;
+
+	float FarReplicationDistance = 10000.f;
+
+	// Every far character is gathered once in this many frames //
+	int32 FarReplicationPeriod = 10;
+
+private:
+	UPROPERTY()
+	TArray<ACameleonGameCharacter*> Characters;
+
+	// Lists of the connection being gathered, they're consumed before the next connection is gathered //
+
+	FActorRepListRefView NearList;
+
+	FActorRepListRefView FarList;
+
+	// Scratch buffer for the scan volume queries //
+	TArray<ACameleonGameCharacter*> CharactersInScan;
+};
+
+// Replication graph of the game, set as the replication driver of the net driver in DefaultEngine.ini. //
+// The controllable characters go to the scan node, the always relevant actors to a single list and the rest //
+// of them are spatialized in a grid //
+UCLASS(transient, config = Engine)
+class CAMELEONGAME_API UCameleonReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo,
+	                                         FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+private:
+	// See UReplicationGraphNode_CameleonScan //
+
+	UPROPERTY(Config)
+	float ScanRelevancyMargin = 500.f;
+
+	UPROPERTY(Config)
+	float FarReplicationDistance = 10000.f;
+
+	UPROPERTY(Config)
+	int32 FarReplicationPeriod = 10;
+
+	// Cell size of the grid the other actors are spatialized in //
+	UPROPERTY(Config)
+	float GridCellSize = 10000.f;
+
+	// Lowest corner of the grid //
+	UPROPERTY(Config)
+	FVector2D GridSpatialBias = {-100000.f, -100000.f};
+
+	UPROPERTY()
+	UReplicationGraphNode_CameleonScan* ScanNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+};
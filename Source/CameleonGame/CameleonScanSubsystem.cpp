@@ -0,0 +1,212 @@
+#include "CameleonScanSubsystem.h"
+#include "CameleonGameCharacter.h"
+#include "Components/CapsuleComponent.h"
+
+void UCameleonScanSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	CharacterGrid.SetCellSize(CellSize);
+
+	Queries.SetNum(MaxScanQueries);
+	QueryRefCounts.SetNumZeroed(MaxScanQueries);
+}
+
+void UCameleonScanSubsystem::Deinitialize()
+{
+	for (const auto& movedHandle : MovedHandles)
+	{
+		if (IsValid(movedHandle.Key) && movedHandle.Key->GetRootComponent())
+		{
+			movedHandle.Key->GetRootComponent()->TransformUpdated.Remove(movedHandle.Value);
+		}
+	}
+
+	MovedHandles.Empty();
+	Characters.Empty();
+	CharacterGrid.Reset();
+	Queries.Empty();
+	QueryRefCounts.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCameleonScanSubsystem::RegisterCharacter(ACameleonGameCharacter* Character)
+{
+	if (!Character || CharacterGrid.Contains(Character))
+	{
+		return;
+	}
+
+	float radius, halfHeight;
+	Character->GetCapsuleComponent()->GetScaledCapsuleSize(radius, halfHeight);
+	MaxCharacterExtent = MaxCharacterExtent.ComponentMax({radius, radius, halfHeight});
+
+	Characters.Add(Character);
+	CharacterGrid.Add(Character, Character->GetActorLocation());
+
+	// We'll be notified whenever the character moves so we don't have to poll its location
+	if (auto rootComponent = Character->GetRootComponent())
+	{
+		MovedHandles.Add(Character,
+		                 rootComponent->TransformUpdated.AddUObject(this, &UCameleonScanSubsystem::OnCharacterMoved));
+	}
+
+	UpdateCharacterQueries(Character);
+}
+
+void UCameleonScanSubsystem::UnregisterCharacter(ACameleonGameCharacter* Character)
+{
+	if (CharacterGrid.Contains(Character))
+	{
+		Characters.RemoveSingleSwap(Character, false);
+		CharacterGrid.Remove(Character);
+
+		FDelegateHandle movedHandle;
+		if (MovedHandles.RemoveAndCopyValue(Character, movedHandle) && Character->GetRootComponent())
+		{
+			Character->GetRootComponent()->TransformUpdated.Remove(movedHandle);
+		}
+
+		Character->ScanQueryMask = 0;
+	}
+}
+
+int32 UCameleonScanSubsystem::RegisterQuery(const FGameplayTagQuery& Query)
+{
+	int32 freeIndex = INDEX_NONE;
+
+	for (int32 queryIdx = 0; queryIdx < QueryRefCounts.Num(); ++queryIdx)
+	{
+		if (QueryRefCounts[queryIdx] == 0)
+		{
+			freeIndex = freeIndex == INDEX_NONE ? queryIdx : freeIndex;
+		}
+		else if (Queries[queryIdx] == Query)
+		{
+			++QueryRefCounts[queryIdx];
+			return queryIdx;
+		}
+	}
+
+	if (!ensureMsgf(freeIndex != INDEX_NONE, TEXT("Too many scan queries registered, the limit is %d"), MaxScanQueries))
+	{
+		return INDEX_NONE;
+	}
+
+	Queries[freeIndex] = Query;
+	QueryRefCounts[freeIndex] = 1;
+
+	// Evaluate the new query for everyone who's already registered
+
+	const uint32 queryBit = 1u << freeIndex;
+	for (auto character : Characters)
+	{
+		if (Query.Matches(character->GameplayTags))
+		{
+			character->ScanQueryMask |= queryBit;
+		}
+		else
+		{
+			character->ScanQueryMask &= ~queryBit;
+		}
+	}
+
+	return freeIndex;
+}
+
+void UCameleonScanSubsystem::UnregisterQuery(const int32 QueryIndex)
+{
+	if (!QueryRefCounts.IsValidIndex(QueryIndex) || QueryRefCounts[QueryIndex] == 0)
+	{
+		return;
+	}
+
+	if (--QueryRefCounts[QueryIndex] == 0)
+	{
+		Queries[QueryIndex] = FGameplayTagQuery::EmptyQuery;
+
+		const uint32 queryBit = 1u << QueryIndex;
+		for (auto character : Characters)
+		{
+			character->ScanQueryMask &= ~queryBit;
+		}
+	}
+}
+
+void UCameleonScanSubsystem::UpdateCharacterQueries(ACameleonGameCharacter* Character)
+{
+	if (!CharacterGrid.Contains(Character))
+	{
+		return;
+	}
+
+	// The tags are matched in place, nothing is copied
+
+	uint32 queryMask = 0;
+	for (int32 queryIdx = 0; queryIdx < QueryRefCounts.Num(); ++queryIdx)
+	{
+		if (QueryRefCounts[queryIdx] > 0 && Queries[queryIdx].Matches(Character->GameplayTags))
+		{
+			queryMask |= 1u << queryIdx;
+		}
+	}
+
+	Character->ScanQueryMask = queryMask;
+}
+
+void UCameleonScanSubsystem::QueryScanVolume(const FTransform& VolumeTransform,
+                                             const FVector& Extent,
+                                             TArray<ACameleonGameCharacter*>& OutCharacters,
+                                             const int32 QueryIndex) const
+{
+	OutCharacters.Reset();
+
+	// Broad phase - gather everything from the cells touched by the volume's bounding box
+
+	FTransform volumeTransform = VolumeTransform;
+	volumeTransform.RemoveScaling();
+
+	const auto bounds = FBox(-Extent, Extent).TransformBy(volumeTransform).ExpandBy(MaxCharacterExtent);
+	CharacterGrid.QueryBounds(bounds, OutCharacters);
+
+	// Narrow phase - the capsule is approximated by the spheres at its center and at both of its ends,
+	// each of them tested against the volume expanded by the capsule radius
+
+	OutCharacters.RemoveAllSwap([&volumeTransform, &Extent, QueryIndex](const ACameleonGameCharacter* Character)
+	{
+		if (QueryIndex != INDEX_NONE && !Character->MatchesScanQuery(QueryIndex))
+		{
+			return true;
+		}
+
+		float radius, halfHeight;
+		Character->GetCapsuleComponent()->GetScaledCapsuleSize(radius, halfHeight);
+
+		const auto location = Character->GetActorLocation();
+		const auto sphereOffset = FVector{0, 0, FMath::Max(halfHeight - radius, 0.f)};
+		const auto expandedExtent = Extent + FVector(radius);
+
+		for (const auto& sphereCenter : {location, location + sphereOffset, location - sphereOffset})
+		{
+			const auto localCenter = volumeTransform.InverseTransformPositionNoScale(sphereCenter);
+			if (FMath::Abs(localCenter.X) <= expandedExtent.X &&
+				FMath::Abs(localCenter.Y) <= expandedExtent.Y &&
+				FMath::Abs(localCenter.Z) <= expandedExtent.Z)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}, false);
+}
+
+void UCameleonScanSubsystem::OnCharacterMoved(USceneComponent* UpdatedComponent,
+                                              EUpdateTransformFlags UpdateTransformFlags,
+                                              ETeleportType Teleport)
+{
+	if (const auto character = Cast<ACameleonGameCharacter>(UpdatedComponent->GetOwner()))
+	{
+		CharacterGrid.Update(character, UpdatedComponent->GetComponentLocation());
+	}
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "GameplayTagContainer.h"
+#include "CameleonSpatialHash.h"
+#include "CameleonScanSubsystem.generated.h"
+
+class ACameleonGameCharacter;
+
+// Keeps every controllable character in a uniform spatial hash so the player controllers //
+// can find what is inside of their scan volume without relying on physics overlaps. The characters //
+// are moved in the grid as they move, nothing is polled //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonScanSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(ACameleonGameCharacter* Character);
+	void UnregisterCharacter(ACameleonGameCharacter* Character);
+
+	// Maximal number of distinct tag queries registered at the same time, one bit of the character's mask each //
+	static constexpr int32 MaxScanQueries = 32;
+
+	// Registers the query to be evaluated whenever the tags of a character change, so that the scans can //
+	// filter the characters by a flag check. Equal queries share the index, returns INDEX_NONE if we're out of them //
+	int32 RegisterQuery(const FGameplayTagQuery& Query);
+
+	void UnregisterQuery(int32 QueryIndex);
+
+	// Re-evaluates the registered queries for the character, called when its tags change //
+	void UpdateCharacterQueries(ACameleonGameCharacter* Character);
+
+	// Collects the characters whose capsule intersects the oriented box described by the transform //
+	// (scale is ignored) and its half extent, only the ones matching the registered query if one is given //
+	void QueryScanVolume(const FTransform& VolumeTransform,
+	                     const FVector& Extent,
+	                     TArray<ACameleonGameCharacter*>& OutCharacters,
+	                     int32 QueryIndex = INDEX_NONE) const;
+
+	int32 GetNumRegisteredCharacters() const
+	{
+		return Characters.Num();
+	}
+
+private:
+	// Re-buckets the character, only the ones crossing a cell boundary touch the grid //
+	void OnCharacterMoved(USceneComponent* UpdatedComponent,
+	                      EUpdateTransformFlags UpdateTransformFlags,
+	                      ETeleportType Teleport);
+
+	// Size of a single grid cell, should be in the ballpark of the scan volume extent //
+	UPROPERTY(Config)
+	float CellSize = 1000.f;
+
+	UPROPERTY()
+	TArray<ACameleonGameCharacter*> Characters;
+
+	// Largest capsule we've registered, used to pad the broad phase so we don't miss characters //
+	// whose origin is outside of the volume but whose capsule isn't //
+	FVector MaxCharacterExtent = FVector::ZeroVector;
+
+	TCameleonSpatialHash<ACameleonGameCharacter*> CharacterGrid;
+
+	// Handles to the transform updated delegates of the characters' root components //
+	TMap<ACameleonGameCharacter*, FDelegateHandle> MovedHandles;
+
+	// Registered queries and the number of their users, the free slots have no users //
+
+	TArray<FGameplayTagQuery> Queries;
+
+	TArray<int32> QueryRefCounts;
+};
@@ -0,0 +1,69 @@
+#include "CameleonSessionRecording.h"
+#include "Misc/FileHelper.h"
+
+FName GetCameleonSessionAxisName(const ECameleonSessionAxis Axis)
+{
+	static const FName axisNames[] = {
+		TEXT("MoveForward"),
+		TEXT("MoveRight"),
+		TEXT("Turn"),
+		TEXT("TurnRate"),
+		TEXT("LookUp"),
+		TEXT("LookUpRate")
+	};
+	static_assert(UE_ARRAY_COUNT(axisNames) == static_cast<uint8>(ECameleonSessionAxis::Num), "Missing axis name");
+
+	return axisNames[static_cast<uint8>(Axis)];
+}
+
+void FCameleonSessionWriter::Begin(const int32 RandomSeed, const FString& MapName)
+{
+	Header = FCameleonSessionHeader();
+	Header.RandomSeed = RandomSeed;
+	Header.FrameSize = sizeof(FCameleonSessionFrame);
+	FCStringAnsi::Strncpy(Header.MapName, TCHAR_TO_ANSI(*MapName), UE_ARRAY_COUNT(Header.MapName));
+
+	Frames.Reset();
+}
+
+bool FCameleonSessionWriter::Save(const FString& Filename) const
+{
+	auto header = Header;
+	header.NumFrames = Frames.Num();
+
+	TArray<uint8> data;
+	data.Reserve(sizeof(FCameleonSessionHeader) + Frames.Num() * sizeof(FCameleonSessionFrame));
+	data.Append(reinterpret_cast<const uint8*>(&header), sizeof(FCameleonSessionHeader));
+	data.Append(reinterpret_cast<const uint8*>(Frames.GetData()), Frames.Num() * sizeof(FCameleonSessionFrame));
+
+	return FFileHelper::SaveArrayToFile(data, *Filename);
+}
+
+bool FCameleonSessionReader::Open(const FString& Filename)
+{
+	if (!File.Open(Filename))
+	{
+		return false;
+	}
+
+	// The frames are read in place, the layout has to match exactly
+
+	const int64 size = File.GetSize();
+
+	if (size < static_cast<int64>(sizeof(FCameleonSessionHeader)) ||
+		GetHeader().Magic != FCameleonSessionHeader::ExpectedMagic ||
+		GetHeader().Version != FCameleonSessionHeader::CurrentVersion ||
+		GetHeader().FrameSize != sizeof(FCameleonSessionFrame) ||
+		size < static_cast<int64>(sizeof(FCameleonSessionHeader) + GetHeader().NumFrames * sizeof(FCameleonSessionFrame)))
+	{
+		File.Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FCameleonSessionReader::Close()
+{
+	File.Close();
+}
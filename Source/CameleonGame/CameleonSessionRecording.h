@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CameleonMappedFile.h"
+
+// Inputs of the player controller which are recorded, one bit each in a recorded frame //
+enum class ECameleonSessionAction : uint8
+{
+	NextCharacter,
+	PreviousCharacter,
+	SwitchCharacter,
+	UseInteractable,
+	ToggleScan,
+	Jump,
+	Num
+};
+
+// Axis inputs of the character which are recorded //
+enum class ECameleonSessionAxis : uint8
+{
+	MoveForward,
+	MoveRight,
+	Turn,
+	TurnRate,
+	LookUp,
+	LookUpRate,
+	Num
+};
+
+// Name of the axis mapping in DefaultInput.ini //
+CAMELEONGAME_API FName GetCameleonSessionAxisName(ECameleonSessionAxis Axis);
+
+// A recorded session file is the header followed by NumFrames frames of FrameSize bytes, little-endian. //
+// Everything is 4 bytes aligned so that the frames can be read in place from a memory-mapped file //
+struct FCameleonSessionHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x53534D43; // "CMSS"
+	static constexpr uint32 CurrentVersion = 2;
+
+	uint32 Magic = ExpectedMagic;
+
+	uint32 Version = CurrentVersion;
+
+	// Seed of the random streams when the recording started //
+	int32 RandomSeed = 0;
+
+	uint32 NumFrames = 0;
+
+	uint32 FrameSize = 0;
+
+	// Map the session was recorded in, without the PIE prefix //
+	ANSICHAR MapName[128] = {};
+};
+
+// Inputs of the local player during a single frame //
+struct FCameleonSessionFrame
+{
+	// Bit per ECameleonSessionAction pressed during the frame //
+	uint32 Actions = 0;
+
+	float Axes[static_cast<uint8>(ECameleonSessionAxis::Num)] = {};
+
+	// Time the frame advanced the game by, the replay advances it by the same //
+	float DeltaTime = 0.f;
+
+	bool HasAction(const ECameleonSessionAction Action) const
+	{
+		return (Actions & (1u << static_cast<uint8>(Action))) != 0;
+	}
+
+	void AddAction(const ECameleonSessionAction Action)
+	{
+		Actions |= 1u << static_cast<uint8>(Action);
+	}
+};
+
+static_assert(sizeof(FCameleonSessionHeader) % 4 == 0, "The frames have to stay aligned after the header");
+
+// Collects the frames of a session in memory and writes them out at once //
+class CAMELEONGAME_API FCameleonSessionWriter
+{
+public:
+	void Begin(int32 RandomSeed, const FString& MapName);
+
+	void AddFrame(const FCameleonSessionFrame& Frame)
+	{
+		Frames.Add(Frame);
+	}
+
+	int32 Num() const
+	{
+		return Frames.Num();
+	}
+
+	bool Save(const FString& Filename) const;
+
+private:
+	FCameleonSessionHeader Header;
+
+	TArray<FCameleonSessionFrame> Frames;
+};
+
+// Reads the frames of a recorded session in place from the mapped file //
+class CAMELEONGAME_API FCameleonSessionReader
+{
+public:
+	// Returns false if the file can't be read or isn't a session of the current version //
+	bool Open(const FString& Filename);
+
+	void Close();
+
+	bool IsOpen() const
+	{
+		return File.IsOpen();
+	}
+
+	const FCameleonSessionHeader& GetHeader() const
+	{
+		return *reinterpret_cast<const FCameleonSessionHeader*>(File.GetData());
+	}
+
+	int32 Num() const
+	{
+		return IsOpen() ? static_cast<int32>(GetHeader().NumFrames) : 0;
+	}
+
+	const FCameleonSessionFrame& GetFrame(const int32 Index) const
+	{
+		check(Index >= 0 && Index < Num());
+		return reinterpret_cast<const FCameleonSessionFrame*>(File.GetData() + sizeof(FCameleonSessionHeader))[Index];
+	}
+
+private:
+	FCameleonMappedFile File;
+};
@@ -0,0 +1,356 @@
+#include "CameleonSessionSubsystem.h"
+#include "CameleonPlayerController.h"
+#include "CameleonProfiling.h"
+#include "Components/InputComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCameleonSession, Log, All);
+
+void UCameleonSessionSubsystem::Deinitialize()
+{
+	StopRecording();
+
+	if (Reader.IsOpen())
+	{
+		FinishReplay();
+	}
+
+	Super::Deinitialize();
+}
+
+void UCameleonSessionSubsystem::RegisterPlayerController(ACameleonPlayerController* PlayerController)
+{
+	// A single local player is recorded or replayed
+	if (!GetWorld()->IsGameWorld() || !PlayerController->IsLocalController() || IsRecording() || IsReplaying())
+	{
+		return;
+	}
+
+	FString name;
+	if (FParse::Value(FCommandLine::Get(), TEXT("CameleonReplaySession="), name))
+	{
+		StartReplay(PlayerController, name);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("CameleonRecordSession="), name))
+	{
+		StartRecording(PlayerController, name);
+	}
+}
+
+void UCameleonSessionSubsystem::UnregisterPlayerController(ACameleonPlayerController* PlayerController)
+{
+	if (RecordingController.Get() == PlayerController)
+	{
+		StopRecording();
+	}
+	else if (ReplayController.Get() == PlayerController)
+	{
+		FinishReplay();
+	}
+}
+
+void UCameleonSessionSubsystem::RecordAction(const ECameleonSessionAction Action)
+{
+	if (IsRecording())
+	{
+		PendingFrame.AddAction(Action);
+	}
+}
+
+void UCameleonSessionSubsystem::OnInputProcessed(ACameleonPlayerController* PlayerController)
+{
+	if (RecordingController.Get() == PlayerController)
+	{
+		RecordFrame(PlayerController);
+	}
+	else if (ReplayController.Get() == PlayerController && NextReplayFrame < Reader.Num())
+	{
+		ReplayFrame(PlayerController, Reader.GetFrame(NextReplayFrame++));
+
+		if (NextReplayFrame < Reader.Num())
+		{
+			FApp::SetFixedDeltaTime(Reader.GetFrame(NextReplayFrame).DeltaTime);
+		}
+	}
+}
+
+void UCameleonSessionSubsystem::StartRecording(ACameleonPlayerController* PlayerController, const FString& Name)
+{
+	int32 seed = 0;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("CameleonSessionSeed="), seed))
+	{
+		seed = FMath::Rand();
+	}
+
+	FMath::RandInit(seed);
+	FMath::SRandInit(seed);
+
+	// Keep the frames even while recording, each frame stores how long it actually lasted for the replay
+	bPreviousUseFixedFrameRate = GEngine->bUseFixedFrameRate;
+	PreviousFixedFrameRate = GEngine->FixedFrameRate;
+	GEngine->bUseFixedFrameRate = true;
+	GEngine->FixedFrameRate = 1.f / FixedDeltaTime;
+
+	RecordingController = PlayerController;
+	RecordingFilename = GetSessionFilename(Name);
+	PendingFrame = FCameleonSessionFrame();
+	Writer.Begin(seed, UWorld::RemovePIEPrefix(GetWorld()->GetMapName()));
+
+	UE_LOG(LogCameleonSession, Display, TEXT("Recording the session to %s with the seed %d"), *RecordingFilename, seed);
+}
+
+void UCameleonSessionSubsystem::StopRecording()
+{
+	if (RecordingFilename.IsEmpty())
+	{
+		return;
+	}
+
+	if (Writer.Save(RecordingFilename))
+	{
+		UE_LOG(LogCameleonSession, Display, TEXT("Recorded %d frames to %s"), Writer.Num(), *RecordingFilename);
+	}
+	else
+	{
+		UE_LOG(LogCameleonSession, Error, TEXT("Couldn't write the session to %s"), *RecordingFilename);
+	}
+
+	GEngine->bUseFixedFrameRate = bPreviousUseFixedFrameRate;
+	GEngine->FixedFrameRate = PreviousFixedFrameRate;
+
+	RecordingController.Reset();
+	RecordingFilename.Empty();
+}
+
+void UCameleonSessionSubsystem::StartReplay(ACameleonPlayerController* PlayerController, const FString& Name)
+{
+	const auto filename = GetSessionFilename(Name);
+	if (!Reader.Open(filename))
+	{
+		UE_LOG(LogCameleonSession, Error, TEXT("Couldn't read the session from %s"), *filename);
+		RequestReplayExit(false);
+		return;
+	}
+
+	// The inputs only make sense in the map they were recorded in
+
+	const auto& header = Reader.GetHeader();
+	const auto mapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	if (mapName != ANSI_TO_TCHAR(header.MapName))
+	{
+		UE_LOG(LogCameleonSession, Error, TEXT("The session was recorded in %s, can't replay it in %s"),
+		       ANSI_TO_TCHAR(header.MapName), *mapName);
+		Reader.Close();
+		RequestReplayExit(false);
+		return;
+	}
+
+	FMath::RandInit(header.RandomSeed);
+	FMath::SRandInit(header.RandomSeed);
+
+	// Every frame advances by its recorded delta time no matter how long it takes, the next one is set up as
+	// each frame is fed to the player
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	if (Reader.Num() > 0)
+	{
+		FApp::SetFixedDeltaTime(Reader.GetFrame(0).DeltaTime);
+	}
+
+	FCameleonFrameProfile::Get().SetEnabled(true);
+
+	ReplayController = PlayerController;
+	ReplayName = FPaths::GetBaseFilename(Name);
+	NextReplayFrame = 0;
+	LastFrameCycles = 0;
+	ReplayTimeline.Reset(Reader.Num());
+
+	UE_LOG(LogCameleonSession, Display, TEXT("Replaying %d frames from %s"), Reader.Num(), *filename);
+}
+
+void UCameleonSessionSubsystem::FinishReplay()
+{
+	ReplayController.Reset();
+	Reader.Close();
+	FCameleonFrameProfile::Get().SetEnabled(false);
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	// One row per frame
+
+	FString csv = TEXT("Frame,FrameMs");
+	for (uint8 sectionIdx = 0; sectionIdx < static_cast<uint8>(ECameleonProfileSection::Num); ++sectionIdx)
+	{
+		csv += FString::Printf(TEXT(",%sMs"),
+		                       FCameleonFrameProfile::GetSectionName(static_cast<ECameleonProfileSection>(sectionIdx)));
+	}
+	csv += LINE_TERMINATOR;
+
+	double totalFrameMs = 0.0;
+	double maxFrameMs = 0.0;
+
+	for (int32 frameIdx = 0; frameIdx < ReplayTimeline.Num(); ++frameIdx)
+	{
+		csv += FString::Printf(TEXT("%d"), frameIdx);
+		for (const double milliseconds : ReplayTimeline[frameIdx])
+		{
+			csv += FString::Printf(TEXT(",%.4f"), milliseconds);
+		}
+		csv += LINE_TERMINATOR;
+
+		totalFrameMs += ReplayTimeline[frameIdx][0];
+		maxFrameMs = FMath::Max(maxFrameMs, ReplayTimeline[frameIdx][0]);
+	}
+
+	const FString reportFilename = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("Cameleon") /
+		TEXT("Replay_") + ReplayName + TEXT(".csv");
+	FFileHelper::SaveStringToFile(csv, *reportFilename);
+
+	UE_LOG(LogCameleonSession, Display, TEXT("Replayed %d frames: frame mean %.3f ms, max %.3f ms, timeline in %s"),
+	       ReplayTimeline.Num(), ReplayTimeline.Num() > 0 ? totalFrameMs / ReplayTimeline.Num() : 0.0, maxFrameMs,
+	       *reportFilename);
+
+	ReplayTimeline.Empty();
+
+	RequestReplayExit(true);
+}
+
+void UCameleonSessionSubsystem::RequestReplayExit(const bool bSucceeded)
+{
+	// Headless runs on the build machines rely on it, they'd hang otherwise
+	if (FParse::Param(FCommandLine::Get(), TEXT("CameleonReplayExit")))
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bSucceeded ? 0 : 1);
+	}
+}
+
+void UCameleonSessionSubsystem::RecordFrame(ACameleonPlayerController* PlayerController)
+{
+	auto frame = PendingFrame;
+	PendingFrame = FCameleonSessionFrame();
+
+	frame.DeltaTime = static_cast<float>(FApp::GetDeltaTime());
+
+	// The axes are bound by the possessed character, their values stay around until the next input is processed
+
+	const auto pawn = PlayerController->GetPawn();
+	if (pawn && pawn->InputComponent)
+	{
+		for (uint8 axisIdx = 0; axisIdx < static_cast<uint8>(ECameleonSessionAxis::Num); ++axisIdx)
+		{
+			frame.Axes[axisIdx] = pawn->InputComponent->GetAxisValue(
+				GetCameleonSessionAxisName(static_cast<ECameleonSessionAxis>(axisIdx)));
+		}
+	}
+
+	const auto character = Cast<ACharacter>(pawn);
+	if (character && character->bPressedJump)
+	{
+		frame.AddAction(ECameleonSessionAction::Jump);
+	}
+
+	Writer.AddFrame(frame);
+}
+
+void UCameleonSessionSubsystem::ReplayFrame(ACameleonPlayerController* PlayerController,
+                                            const FCameleonSessionFrame& Frame) const
+{
+	for (uint8 actionIdx = 0; actionIdx < static_cast<uint8>(ECameleonSessionAction::Num); ++actionIdx)
+	{
+		const auto action = static_cast<ECameleonSessionAction>(actionIdx);
+		if (Frame.HasAction(action))
+		{
+			PlayerController->DispatchSessionAction(action);
+		}
+	}
+
+	// Feed the recorded values to the character's axis bindings the same way the player input does
+
+	const auto pawn = PlayerController->GetPawn();
+	if (!pawn || !pawn->InputComponent)
+	{
+		return;
+	}
+
+	for (auto& axisBinding : pawn->InputComponent->AxisBindings)
+	{
+		for (uint8 axisIdx = 0; axisIdx < static_cast<uint8>(ECameleonSessionAxis::Num); ++axisIdx)
+		{
+			if (axisBinding.AxisName == GetCameleonSessionAxisName(static_cast<ECameleonSessionAxis>(axisIdx)))
+			{
+				axisBinding.AxisValue = Frame.Axes[axisIdx];
+				axisBinding.AxisDelegate.Execute(axisBinding.AxisValue);
+				break;
+			}
+		}
+	}
+}
+
+FString UCameleonSessionSubsystem::GetSessionFilename(const FString& Name)
+{
+	if (FPaths::IsRelative(Name) && FPaths::GetPath(Name).IsEmpty())
+	{
+		return FPaths::ProjectSavedDir() / TEXT("Sessions") / FPaths::SetExtension(Name, TEXT(".cmsession"));
+	}
+
+	return Name;
+}
+
+void UCameleonSessionSubsystem::Tick(float DeltaTime)
+{
+	// Each frame of the replay is timed from the end of the previous one, the profiled sections of the frame
+	// have run by now
+
+	auto& profile = FCameleonFrameProfile::Get();
+	const uint64 cycles = FPlatformTime::Cycles64();
+
+	if (LastFrameCycles != 0)
+	{
+		auto& row = ReplayTimeline.AddDefaulted_GetRef();
+		row.Reserve(1 + static_cast<uint8>(ECameleonProfileSection::Num));
+		row.Add(FPlatformTime::ToMilliseconds64(cycles - LastFrameCycles));
+
+		for (uint8 sectionIdx = 0; sectionIdx < static_cast<uint8>(ECameleonProfileSection::Num); ++sectionIdx)
+		{
+			row.Add(profile.GetMilliseconds(static_cast<ECameleonProfileSection>(sectionIdx)));
+		}
+	}
+
+	LastFrameCycles = cycles;
+	profile.Reset();
+
+	if (NextReplayFrame >= Reader.Num())
+	{
+		FinishReplay();
+	}
+}
+
+bool UCameleonSessionSubsystem::IsTickable() const
+{
+	return IsReplaying();
+}
+
+ETickableTickType UCameleonSessionSubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonSessionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonSessionSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonSessionSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
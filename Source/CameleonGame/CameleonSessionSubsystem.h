@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CameleonSessionRecording.h"
+#include "CameleonSessionSubsystem.generated.h"
+
+class ACameleonPlayerController;
+
+// Records the inputs of the local player into a session file, or replays one with the recorded delta times so that a //
+// captured play session can be used as a repeatable benchmark. Both are started from the command line: //
+//
+//   -CameleonRecordSession=<Name>   records the session to Saved/Sessions/<Name>.cmsession
+//   -CameleonReplaySession=<Name>   replays it, the per-frame timings go to Saved/Benchmarks/Cameleon/Replay_<Name>.csv
+//   -CameleonSessionSeed=<Seed>     seed of the random streams for the recording, picked randomly otherwise
+//   -CameleonReplayExit             quits once the replay is over
+//
+// e.g. UE4Editor CameleonGame <Map> -game -nullrhi -unattended -CameleonReplaySession=Switch -CameleonReplayExit //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonSessionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Starts the recording or the replay requested on the command line for the local player //
+	void RegisterPlayerController(ACameleonPlayerController* PlayerController);
+
+	// Saves the recording of the player //
+	void UnregisterPlayerController(ACameleonPlayerController* PlayerController);
+
+	bool IsRecording() const
+	{
+		return RecordingController.IsValid();
+	}
+
+	bool IsReplaying() const
+	{
+		return ReplayController.IsValid();
+	}
+
+	// Adds the action to the frame being recorded //
+	void RecordAction(ECameleonSessionAction Action);
+
+	// Called once the player's input for the frame has been processed, records the frame or feeds the next one //
+	// of the replay to the player //
+	void OnInputProcessed(ACameleonPlayerController* PlayerController);
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	void StartRecording(ACameleonPlayerController* PlayerController, const FString& Name);
+	void StopRecording();
+
+	void StartReplay(ACameleonPlayerController* PlayerController, const FString& Name);
+	void FinishReplay();
+
+	// Quits with the matching exit code if the replay was started with -CameleonReplayExit //
+	static void RequestReplayExit(bool bSucceeded);
+
+	void RecordFrame(ACameleonPlayerController* PlayerController);
+	void ReplayFrame(ACameleonPlayerController* PlayerController, const FCameleonSessionFrame& Frame) const;
+
+	static FString GetSessionFilename(const FString& Name);
+
+	// The engine runs at this fixed frame rate while recording, the slow frames still last longer //
+	UPROPERTY(Config)
+	float FixedDeltaTime = 1.f / 60.f;
+
+	// Recording //
+
+	TWeakObjectPtr<ACameleonPlayerController> RecordingController;
+
+	FCameleonSessionWriter Writer;
+
+	FString RecordingFilename;
+
+	// Actions pressed since the last recorded frame //
+	FCameleonSessionFrame PendingFrame;
+
+	// Frame rate settings of the engine before the recording, restored once it's over //
+
+	bool bPreviousUseFixedFrameRate = false;
+
+	float PreviousFixedFrameRate = 30.f;
+
+	// Replay //
+
+	TWeakObjectPtr<ACameleonPlayerController> ReplayController;
+
+	FCameleonSessionReader Reader;
+
+	FString ReplayName;
+
+	int32 NextReplayFrame = 0;
+
+	uint64 LastFrameCycles = 0;
+
+	// Timestep settings of the application before the replay, restored once it's over //
+
+	bool bPreviousUseFixedTimeStep = false;
+
+	double PreviousFixedDeltaTime = 1.0 / 30.0;
+
+	// Per-frame timings of the replay: the whole frame followed by every profiled section //
+	TArray<TArray<double>> ReplayTimeline;
+};
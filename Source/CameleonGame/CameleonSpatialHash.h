@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Uniform spatial hash grid. Elements are bucketed by the cell their location falls into, //
+// moving an element only touches the grid when it crosses a cell boundary //
+template <typename ElementType>
+class TCameleonSpatialHash
+{
+public:
+	explicit TCameleonSpatialHash(const float InCellSize = 1000.f)
+	{
+		SetCellSize(InCellSize);
+	}
+
+	// Changing the cell size drops the current contents, elements have to be re-added //
+	void SetCellSize(const float InCellSize)
+	{
+		check(InCellSize > 0.f);
+		CellSize = InCellSize;
+		InvCellSize = 1.f / InCellSize;
+		Reset();
+	}
+
+	float GetCellSize() const
+	{
+		return CellSize;
+	}
+
+	void Reset()
+	{
+		Cells.Reset();
+		ElementCells.Reset();
+	}
+
+	int32 Num() const
+	{
+		return ElementCells.Num();
+	}
+
+	bool Contains(const ElementType& Element) const
+	{
+		return ElementCells.Contains(Element);
+	}
+
+	void Add(const ElementType& Element, const FVector& Location)
+	{
+		if (Contains(Element))
+		{
+			Update(Element, Location);
+			return;
+		}
+
+		const auto cell = ToCell(Location);
+		ElementCells.Add(Element, cell);
+		Cells.FindOrAdd(cell).Add(Element);
+	}
+
+	void Remove(const ElementType& Element)
+	{
+		FIntVector cell;
+		if (ElementCells.RemoveAndCopyValue(Element, cell))
+		{
+			RemoveFromCell(Element, cell);
+		}
+	}
+
+	// Moves the element to the cell matching its new location, returns true if the cell has changed //
+	bool Update(const ElementType& Element, const FVector& Location)
+	{
+		auto currentCell = ElementCells.Find(Element);
+		if (!currentCell)
+		{
+			return false;
+		}
+
+		const auto newCell = ToCell(Location);
+		if (newCell == *currentCell)
+		{
+			return false;
+		}
+
+		RemoveFromCell(Element, *currentCell);
+		Cells.FindOrAdd(newCell).Add(Element);
+		*currentCell = newCell;
+		return true;
+	}
+
+	// Appends every element bucketed in a cell touched by the bounds, the caller does the exact test //
+	void QueryBounds(const FBox& Bounds, TArray<ElementType>& OutElements) const
+	{
+		const auto minCell = ToCell(Bounds.Min);
+		const auto maxCell = ToCell(Bounds.Max);
+
+		for (int32 x = minCell.X; x <= maxCell.X; ++x)
+		{
+			for (int32 y = minCell.Y; y <= maxCell.Y; ++y)
+			{
+				for (int32 z = minCell.Z; z <= maxCell.Z; ++z)
+				{
+					if (const auto cell = Cells.Find(FIntVector(x, y, z)))
+					{
+						OutElements.Append(*cell);
+					}
+				}
+			}
+		}
+	}
+
+	FIntVector ToCell(const FVector& Location) const
+	{
+		return FIntVector(FMath::FloorToInt(Location.X * InvCellSize),
+		                  FMath::FloorToInt(Location.Y * InvCellSize),
+		                  FMath::FloorToInt(Location.Z * InvCellSize));
+	}
+
+private:
+	void RemoveFromCell(const ElementType& Element, const FIntVector& Cell)
+	{
+		if (auto elements = Cells.Find(Cell))
+		{
+			elements->RemoveSingleSwap(Element, false);
+			if (elements->Num() == 0)
+			{
+				Cells.Remove(Cell);
+			}
+		}
+	}
+
+	TMap<FIntVector, TArray<ElementType>> Cells;
+
+	TMap<ElementType, FIntVector> ElementCells;
+
+	float CellSize;
+
+	float InvCellSize;
+};
@@ -0,0 +1,80 @@
+#include "CameleonVisibilityGrid.h"
+
+bool FCameleonVisibilityGrid::Open(const FString& Filename)
+{
+	if (!File.Open(Filename))
+	{
+		return false;
+	}
+
+	// The bit sets are read in place, the layout has to match exactly
+
+	const int64 size = File.GetSize();
+
+	if (size < static_cast<int64>(sizeof(FCameleonVisibilityGridHeader)))
+	{
+		File.Close();
+		return false;
+	}
+
+	const auto& header = GetHeader();
+	const int64 expectedSize = sizeof(FCameleonVisibilityGridHeader) +
+		(1 + static_cast<int64>(header.NumCells)) * header.WordsPerSet * sizeof(uint32);
+
+	if (header.Magic != FCameleonVisibilityGridHeader::ExpectedMagic ||
+		header.Version != FCameleonVisibilityGridHeader::CurrentVersion ||
+		header.CellSize <= 0.f ||
+		header.NumCells != static_cast<uint32>(header.Dimensions.X * header.Dimensions.Y * header.Dimensions.Z) ||
+		header.WordsPerSet != FCameleonVisibilityGridHeader::GetWordsPerSet(header.NumCells) ||
+		size < expectedSize)
+	{
+		File.Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FCameleonVisibilityGrid::Close()
+{
+	File.Close();
+}
+
+int32 FCameleonVisibilityGrid::FindOpenCell(const FVector& Location) const
+{
+	const auto& header = GetHeader();
+	const auto cellLocation = (Location - header.Origin) / header.CellSize;
+
+	const int32 x = FMath::FloorToInt(cellLocation.X);
+	const int32 y = FMath::FloorToInt(cellLocation.Y);
+	const int32 z = FMath::FloorToInt(cellLocation.Z);
+
+	if (x < 0 || y < 0 || z < 0 ||
+		x >= header.Dimensions.X || y >= header.Dimensions.Y || z >= header.Dimensions.Z)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 cellIndex = x + header.Dimensions.X * (y + header.Dimensions.Y * z);
+
+	// The first set holds the open cells
+	return HasBit(GetSet(0), cellIndex) ? cellIndex : INDEX_NONE;
+}
+
+ECameleonBakedVisibility FCameleonVisibilityGrid::Query(const FVector& From, const FVector& To) const
+{
+	if (!IsOpen())
+	{
+		return ECameleonBakedVisibility::Unknown;
+	}
+
+	const int32 fromCell = FindOpenCell(From);
+	const int32 toCell = FindOpenCell(To);
+
+	if (fromCell == INDEX_NONE || toCell == INDEX_NONE)
+	{
+		return ECameleonBakedVisibility::Unknown;
+	}
+
+	return HasBit(GetSet(1 + fromCell), toCell) ? ECameleonBakedVisibility::Visible : ECameleonBakedVisibility::Hidden;
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CameleonMappedFile.h"
+
+enum class ECameleonBakedVisibility : uint8
+{
+	// One of the points is outside of the baked cells or inside of the geometry, a trace has to decide //
+	Unknown,
+	// The cells can see each other, the line between the points may still be blocked //
+	Visible,
+	// No static geometry lets the cells see each other //
+	Hidden
+};
+
+// A baked visibility grid is the header, the bit set of the open cells and a bit set of the cells visible //
+// from each cell, NumCells of them. The bit sets are WordsPerSet 32 bit words long, little-endian //
+struct FCameleonVisibilityGridHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x53564D43; // "CMVS"
+	static constexpr uint32 CurrentVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+
+	uint32 Version = CurrentVersion;
+
+	float CellSize = 0.f;
+
+	// Minimal corner of the first cell //
+	FVector Origin = FVector::ZeroVector;
+
+	FIntVector Dimensions = FIntVector::ZeroValue;
+
+	uint32 NumCells = 0;
+
+	uint32 WordsPerSet = 0;
+
+	static uint32 GetWordsPerSet(const uint32 NumCells)
+	{
+		return (NumCells + 31) / 32;
+	}
+};
+
+static_assert(sizeof(FCameleonVisibilityGridHeader) % 4 == 0, "The bit sets have to stay aligned after the header");
+
+// Potentially visible sets between the cells of a coarse grid over the static geometry of a level, //
+// baked by UCameleonBakeVisibilityCommandlet and read in place from the mapped file //
+class CAMELEONGAME_API FCameleonVisibilityGrid
+{
+public:
+	// Returns false if the file can't be read or isn't a grid of the current version //
+	bool Open(const FString& Filename);
+
+	void Close();
+
+	bool IsOpen() const
+	{
+		return File.IsOpen();
+	}
+
+	const FCameleonVisibilityGridHeader& GetHeader() const
+	{
+		return *reinterpret_cast<const FCameleonVisibilityGridHeader*>(File.GetData());
+	}
+
+	// Index of the open cell containing the point, INDEX_NONE if there's none //
+	int32 FindOpenCell(const FVector& Location) const;
+
+	ECameleonBakedVisibility Query(const FVector& From, const FVector& To) const;
+
+private:
+	static bool HasBit(const uint32* Set, const int32 Index)
+	{
+		return (Set[Index >> 5] & (1u << (Index & 31))) != 0;
+	}
+
+	const uint32* GetSet(const int32 SetIndex) const
+	{
+		return reinterpret_cast<const uint32*>(File.GetData() + sizeof(FCameleonVisibilityGridHeader)) +
+			SetIndex * GetHeader().WordsPerSet;
+	}
+
+	FCameleonMappedFile File;
+};
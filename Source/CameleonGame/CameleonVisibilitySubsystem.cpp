@@ -0,0 +1,195 @@
+#include "CameleonVisibilitySubsystem.h"
+#include "CameleonProfiling.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked Visibility Queries"), STAT_Cameleon_BakedVisibilityQueries, STATGROUP_Cameleon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked Visibility Unknown"), STAT_Cameleon_BakedVisibilityUnknown, STATGROUP_Cameleon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Line Of Sight Cache Hits"), STAT_Cameleon_LineOfSightHits, STATGROUP_Cameleon);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Line Of Sight Cache Misses"), STAT_Cameleon_LineOfSightMisses, STATGROUP_Cameleon);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Line Of Sight Cache Entries"), STAT_Cameleon_LineOfSightEntries, STATGROUP_Cameleon);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Line Of Sight Cache Hit Rate"), STAT_Cameleon_LineOfSightHitRate, STATGROUP_Cameleon);
+
+DEFINE_LOG_CATEGORY_STATIC(LogCameleonVisibility, Log, All);
+
+void UCameleonVisibilitySubsystem::Deinitialize()
+{
+	Grid.Close();
+	LineOfSightCache.Empty();
+	LineOfSightKeys.Empty();
+
+	Super::Deinitialize();
+}
+
+ECameleonBakedVisibility UCameleonVisibilitySubsystem::QueryVisibility(const FVector& From, const FVector& To)
+{
+	if (!bUseBakedVisibility)
+	{
+		return ECameleonBakedVisibility::Unknown;
+	}
+
+	if (!bGridLoadAttempted)
+	{
+		bGridLoadAttempted = true;
+
+		const auto mapPackageName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+		const auto filename = GetBakedGridFilename(mapPackageName);
+
+		if (Grid.Open(filename))
+		{
+			UE_LOG(LogCameleonVisibility, Log, TEXT("Loaded the visibility grid of %s, %u cells"),
+			       *mapPackageName, Grid.GetHeader().NumCells);
+		}
+		else
+		{
+			UE_LOG(LogCameleonVisibility, Log, TEXT("No visibility grid baked for %s, tracing instead"), *mapPackageName);
+		}
+	}
+
+	const auto visibility = Grid.Query(From, To);
+
+	INC_DWORD_STAT(STAT_Cameleon_BakedVisibilityQueries);
+	if (visibility == ECameleonBakedVisibility::Unknown)
+	{
+		INC_DWORD_STAT(STAT_Cameleon_BakedVisibilityUnknown);
+	}
+
+	return visibility;
+}
+
+FString UCameleonVisibilitySubsystem::GetBakedGridFilename(const FString& MapPackageName)
+{
+	return FPaths::ProjectContentDir() / TEXT("Visibility") /
+		FPackageName::GetShortName(MapPackageName) + TEXT(".cmvis");
+}
+
+bool UCameleonVisibilitySubsystem::FindLineOfSight(const AActor* Viewer,
+                                                   const AActor* Target,
+                                                   const FVector& From,
+                                                   const FVector& To,
+                                                   bool& bOutVisible)
+{
+	if (!bCacheLineOfSight)
+	{
+		return false;
+	}
+
+	const auto key = MakeTuple(FObjectKey(Viewer), FObjectKey(Target));
+	const auto entry = LineOfSightCache.Find(key);
+
+	const float moveThresholdSquared = FMath::Square(LineOfSightMoveThreshold);
+
+	if (!entry ||
+		GetWorld()->GetTimeSeconds() - entry->Time > MaxLineOfSightAge ||
+		FVector::DistSquared(entry->From, From) > moveThresholdSquared ||
+		FVector::DistSquared(entry->To, To) > moveThresholdSquared)
+	{
+		++NumLineOfSightMisses;
+		INC_DWORD_STAT(STAT_Cameleon_LineOfSightMisses);
+		return false;
+	}
+
+	++NumLineOfSightHits;
+	INC_DWORD_STAT(STAT_Cameleon_LineOfSightHits);
+
+	bOutVisible = entry->bVisible;
+	return true;
+}
+
+void UCameleonVisibilitySubsystem::StoreLineOfSight(const AActor* Viewer,
+                                                    const AActor* Target,
+                                                    const FVector& From,
+                                                    const FVector& To,
+                                                    const bool bVisible)
+{
+	if (!bCacheLineOfSight || MaxLineOfSightEntries <= 0)
+	{
+		return;
+	}
+
+	const auto key = MakeTuple(FObjectKey(Viewer), FObjectKey(Target));
+
+	auto entry = LineOfSightCache.Find(key);
+	if (!entry)
+	{
+		// Once the ring is full the new key takes the slot of the oldest one, which drops its result unless it's
+		// been removed and added to another slot since
+
+		int32 keySlot = LineOfSightKeys.Num();
+		if (keySlot < MaxLineOfSightEntries)
+		{
+			LineOfSightKeys.Add(key);
+		}
+		else
+		{
+			keySlot = NextLineOfSightKeySlot;
+			NextLineOfSightKeySlot = (NextLineOfSightKeySlot + 1) % LineOfSightKeys.Num();
+
+			const auto oldestEntry = LineOfSightCache.Find(LineOfSightKeys[keySlot]);
+			if (oldestEntry && oldestEntry->KeySlot == keySlot)
+			{
+				LineOfSightCache.Remove(LineOfSightKeys[keySlot]);
+			}
+
+			LineOfSightKeys[keySlot] = key;
+		}
+
+		entry = &LineOfSightCache.Add(key);
+		entry->KeySlot = keySlot;
+	}
+
+	entry->From = From;
+	entry->To = To;
+	entry->Time = GetWorld()->GetTimeSeconds();
+	entry->bVisible = bVisible;
+}
+
+void UCameleonVisibilitySubsystem::InvalidateLineOfSight(const FBox& Bounds)
+{
+	for (auto entryIt = LineOfSightCache.CreateIterator(); entryIt; ++entryIt)
+	{
+		const auto& entry = entryIt->Value;
+		const auto extent = entry.To - entry.From;
+
+		if (FMath::LineBoxIntersection(Bounds, entry.From, entry.To, extent))
+		{
+			entryIt.RemoveCurrent();
+		}
+	}
+}
+
+void UCameleonVisibilitySubsystem::Tick(float DeltaTime)
+{
+	const int32 numLookups = NumLineOfSightHits + NumLineOfSightMisses;
+	const float hitRate = numLookups > 0 ? static_cast<float>(NumLineOfSightHits) / numLookups : 0.f;
+
+	SET_FLOAT_STAT(STAT_Cameleon_LineOfSightHitRate, hitRate);
+	SET_DWORD_STAT(STAT_Cameleon_LineOfSightEntries, LineOfSightCache.Num());
+	CSV_CUSTOM_STAT(Cameleon, LineOfSightHitRate, hitRate, ECsvCustomStatOp::Set);
+
+	NumLineOfSightHits = 0;
+	NumLineOfSightMisses = 0;
+}
+
+bool UCameleonVisibilitySubsystem::IsTickable() const
+{
+	return LineOfSightCache.Num() > 0 || NumLineOfSightMisses > 0;
+}
+
+ETickableTickType UCameleonVisibilitySubsystem::GetTickableTickType() const
+{
+	// The class default object would tick as well otherwise
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UCameleonVisibilitySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCameleonVisibilitySubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCameleonVisibilitySubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+#include "CameleonVisibilityGrid.h"
+#include "CameleonVisibilitySubsystem.generated.h"
+
+// Result of a line of sight trace between two actors along with where they were //
+struct FCameleonLineOfSightEntry
+{
+	FVector From = FVector::ZeroVector;
+
+	FVector To = FVector::ZeroVector;
+
+	float Time = 0.f;
+
+	// Slot of the entry's key in the ring of the keys in the order they were added //
+	int32 KeySlot = INDEX_NONE;
+
+	bool bVisible = false;
+};
+
+// Answers the line of sight queries from the visibility grid baked for the level, the grid is looked up //
+// in Content/Visibility/<Map>.cmvis when the first query is made. Levels without a baked grid answer //
+// every query with Unknown. //
+// Also caches the results of the line of sight traces per viewer and target, a result is reused until //
+// either of them moves, it gets too old or the geometry around the line changes //
+UCLASS(config = Game)
+class CAMELEONGAME_API UCameleonVisibilitySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	ECameleonBakedVisibility QueryVisibility(const FVector& From, const FVector& To);
+
+	// Returns true and the cached result if the viewer has traced to the target from about the same place //
+	bool FindLineOfSight(const AActor* Viewer, const AActor* Target, const FVector& From, const FVector& To,
+	                     bool& bOutVisible);
+
+	void StoreLineOfSight(const AActor* Viewer, const AActor* Target, const FVector& From, const FVector& To,
+	                      bool bVisible);
+
+	// Forgets the results of the lines passing through the box, e.g. when a door opens //
+	void InvalidateLineOfSight(const FBox& Bounds);
+
+	// Where the grid of the map is baked to and loaded from, the directory is staged as loose files //
+	// so that the grid can be mapped in the packaged game //
+	static FString GetBakedGridFilename(const FString& MapPackageName);
+
+	// FTickableGameObject interface
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	// End of FTickableGameObject interface
+
+private:
+	// Should the queries use the baked grid, off to always fall back to the traces //
+	UPROPERTY(Config)
+	bool bUseBakedVisibility = true;
+
+	// Should the results of the line of sight traces be reused //
+	UPROPERTY(Config)
+	bool bCacheLineOfSight = true;
+
+	// A cached result is traced again once the viewer or the target moves further than this //
+	UPROPERTY(Config)
+	float LineOfSightMoveThreshold = 25.f;
+
+	// Seconds after which a cached result is traced again, catches the changes nobody has invalidated //
+	UPROPERTY(Config)
+	float MaxLineOfSightAge = 1.f;
+
+	// Number of cached results, the one added first is dropped to make room for a new one //
+	UPROPERTY(Config)
+	int32 MaxLineOfSightEntries = 4096;
+
+	FCameleonVisibilityGrid Grid;
+
+	bool bGridLoadAttempted = false;
+
+	TMap<TPair<FObjectKey, FObjectKey>, FCameleonLineOfSightEntry> LineOfSightCache;
+
+	// Keys of the cached results in the order they were added, wraps around at MaxLineOfSightEntries. A slot //
+	// may still hold the key of a result removed meanwhile //
+	TArray<TPair<FObjectKey, FObjectKey>> LineOfSightKeys;
+
+	// Slot of the next key once the ring is full //
+	int32 NextLineOfSightKeySlot = 0;
+
+	// Cache lookups during the current frame //
+
+	int32 NumLineOfSightHits = 0;
+
+	int32 NumLineOfSightMisses = 0;
+};
@@ -0,0 +1,272 @@
+#include "CameleonBakeVisibilityCommandlet.h"
+#include "CameleonVisibilityGrid.h"
+#include "CameleonVisibilitySubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCameleonBakeVisibility, Log, All);
+
+UCameleonBakeVisibilityCommandlet::UCameleonBakeVisibilityCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UCameleonBakeVisibilityCommandlet::Main(const FString& Params)
+{
+	FString maps;
+	if (!FParse::Value(*Params, TEXT("Map="), maps))
+	{
+		UE_LOG(LogCameleonBakeVisibility, Error, TEXT("No map to bake, pass -Map=<Map>+<Map>"));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+	FParse::Value(*Params, TEXT("MaxCells="), MaxCells);
+	FParse::Value(*Params, TEXT("Samples="), NumSamples);
+	FParse::Value(*Params, TEXT("MaxDistance="), MaxDistance);
+
+	CellSize = FMath::Max(CellSize, 50.f);
+	MaxCells = FMath::Max(MaxCells, 1);
+	NumSamples = FMath::Max(NumSamples, 1);
+
+	TArray<FString> mapPackageNames;
+	maps.ParseIntoArray(mapPackageNames, TEXT("+"));
+
+	int32 numFailed = 0;
+	for (const auto& mapPackageName : mapPackageNames)
+	{
+		numFailed += BakeMap(mapPackageName) ? 0 : 1;
+	}
+
+	return numFailed > 0 ? 1 : 0;
+}
+
+bool UCameleonBakeVisibilityCommandlet::BakeMap(const FString& MapPackageName) const
+{
+	const auto package = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	const auto world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+
+	if (!world)
+	{
+		UE_LOG(LogCameleonBakeVisibility, Error, TEXT("Couldn't load %s"), *MapPackageName);
+		return false;
+	}
+
+	// Only the collision of the level is needed, with every streaming level loaded
+
+	world->WorldType = EWorldType::Editor;
+	world->AddToRoot();
+
+	if (!world->bIsWorldInitialized)
+	{
+		world->InitWorld(UWorld::InitializationValues()
+		                 .AllowAudioPlayback(false)
+		                 .CreatePhysicsScene(true)
+		                 .RequiresHitProxies(false)
+		                 .CreateNavigation(false)
+		                 .CreateAISystem(false)
+		                 .ShouldSimulatePhysics(false)
+		                 .SetTransactional(false));
+	}
+
+	world->UpdateWorldComponents(true, false);
+
+	for (auto streamingLevel : world->GetStreamingLevels())
+	{
+		if (streamingLevel)
+		{
+			streamingLevel->SetShouldBeLoaded(true);
+			streamingLevel->SetShouldBeVisible(true);
+		}
+	}
+	world->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	const double startTime = FPlatformTime::Seconds();
+
+	TArray<uint8> data;
+	BakeGrid(world, data);
+
+	world->CleanupWorld();
+	world->RemoveFromRoot();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	if (data.Num() == 0)
+	{
+		UE_LOG(LogCameleonBakeVisibility, Error, TEXT("%s has no static geometry to bake"), *MapPackageName);
+		return false;
+	}
+
+	const auto filename = UCameleonVisibilitySubsystem::GetBakedGridFilename(MapPackageName);
+	if (!FFileHelper::SaveArrayToFile(data, *filename))
+	{
+		UE_LOG(LogCameleonBakeVisibility, Error, TEXT("Couldn't write %s"), *filename);
+		return false;
+	}
+
+	const auto& header = *reinterpret_cast<const FCameleonVisibilityGridHeader*>(data.GetData());
+	UE_LOG(LogCameleonBakeVisibility, Display, TEXT("Baked %s to %s: %dx%dx%d cells of %.0f cm, %d KB in %.1f s"),
+	       *MapPackageName, *filename, header.Dimensions.X, header.Dimensions.Y, header.Dimensions.Z, header.CellSize,
+	       data.Num() / 1024, FPlatformTime::Seconds() - startTime);
+
+	return true;
+}
+
+void UCameleonBakeVisibilityCommandlet::BakeGrid(UWorld* World, TArray<uint8>& OutData) const
+{
+	FBox bounds(ForceInit);
+	for (const auto level : World->GetLevels())
+	{
+		bounds += ALevelBounds::CalculateLevelBounds(level);
+	}
+
+	if (!bounds.IsValid)
+	{
+		return;
+	}
+
+	// Grow the cells until the grid fits
+
+	FCameleonVisibilityGridHeader header;
+	header.CellSize = CellSize;
+	header.Origin = bounds.Min;
+
+	for (;;)
+	{
+		const auto size = bounds.GetSize() / header.CellSize;
+		header.Dimensions = FIntVector(FMath::Max(1, FMath::CeilToInt(size.X)),
+		                               FMath::Max(1, FMath::CeilToInt(size.Y)),
+		                               FMath::Max(1, FMath::CeilToInt(size.Z)));
+
+		const int64 numCells = static_cast<int64>(header.Dimensions.X) * header.Dimensions.Y * header.Dimensions.Z;
+		if (numCells <= MaxCells)
+		{
+			header.NumCells = numCells;
+			break;
+		}
+
+		header.CellSize *= 1.25f;
+	}
+
+	header.WordsPerSet = FCameleonVisibilityGridHeader::GetWordsPerSet(header.NumCells);
+
+	const int32 numCells = header.NumCells;
+	const int32 wordsPerSet = header.WordsPerSet;
+
+	// The first set holds the open cells, the rest the cells visible from each cell
+	TArray<uint32> sets;
+	sets.SetNumZeroed((1 + numCells) * wordsPerSet);
+
+	auto setBit = [&sets, wordsPerSet](const int32 SetIndex, const int32 Index)
+	{
+		sets[SetIndex * wordsPerSet + (Index >> 5)] |= 1u << (Index & 31);
+	};
+
+	auto getBit = [&sets, wordsPerSet](const int32 SetIndex, const int32 Index)
+	{
+		return (sets[SetIndex * wordsPerSet + (Index >> 5)] & (1u << (Index & 31))) != 0;
+	};
+
+	// Only the static geometry blocking the camera is baked, the rest moves
+
+	FCollisionQueryParams queryParams(SCENE_QUERY_STAT(CameleonBakeVisibility), false);
+	queryParams.MobilityType = EQueryMobilityType::Static;
+
+	const auto probe = FCollisionShape::MakeSphere(5.f);
+
+	// Pick the sample points of every cell which aren't inside of the geometry, a cell is open if its center isn't
+
+	TArray<TArray<FVector, TInlineAllocator<8>>> samples;
+	samples.SetNum(numCells);
+
+	for (int32 cellIdx = 0; cellIdx < numCells; ++cellIdx)
+	{
+		const int32 x = cellIdx % header.Dimensions.X;
+		const int32 y = (cellIdx / header.Dimensions.X) % header.Dimensions.Y;
+		const int32 z = cellIdx / (header.Dimensions.X * header.Dimensions.Y);
+
+		const auto center = header.Origin + (FVector(x, y, z) + 0.5f) * header.CellSize;
+		if (World->OverlapBlockingTestByChannel(center, FQuat::Identity, ECC_Camera, probe, queryParams))
+		{
+			continue;
+		}
+
+		setBit(0, cellIdx);
+		samples[cellIdx].Add(center);
+
+		FRandomStream randomStream(cellIdx);
+		for (int32 sampleIdx = 1; sampleIdx < NumSamples; ++sampleIdx)
+		{
+			const auto offset = FVector(randomStream.FRandRange(-0.4f, 0.4f),
+			                            randomStream.FRandRange(-0.4f, 0.4f),
+			                            randomStream.FRandRange(-0.4f, 0.4f)) * header.CellSize;
+
+			if (!World->OverlapBlockingTestByChannel(center + offset, FQuat::Identity, ECC_Camera, probe, queryParams))
+			{
+				samples[cellIdx].Add(center + offset);
+			}
+		}
+	}
+
+	// Each row only fills the cells after its own so that the rows can be traced in parallel,
+	// the visibility is symmetric and gets mirrored afterwards
+
+	const float maxDistanceSquared = FMath::Square(MaxDistance);
+
+	ParallelFor(numCells, [&](const int32 FromCell)
+	{
+		const auto& fromSamples = samples[FromCell];
+		if (fromSamples.Num() == 0)
+		{
+			return;
+		}
+
+		setBit(1 + FromCell, FromCell);
+
+		for (int32 toCell = FromCell + 1; toCell < numCells; ++toCell)
+		{
+			const auto& toSamples = samples[toCell];
+			if (toSamples.Num() == 0)
+			{
+				continue;
+			}
+
+			bool bVisible = FVector::DistSquared(fromSamples[0], toSamples[0]) > maxDistanceSquared;
+
+			const int32 numRays = FMath::Min(fromSamples.Num(), toSamples.Num());
+			for (int32 rayIdx = 0; !bVisible && rayIdx < numRays; ++rayIdx)
+			{
+				bVisible = !World->LineTraceTestByChannel(fromSamples[rayIdx], toSamples[rayIdx], ECC_Camera, queryParams);
+			}
+
+			if (bVisible)
+			{
+				setBit(1 + FromCell, toCell);
+			}
+		}
+	});
+
+	for (int32 fromCell = 0; fromCell < numCells; ++fromCell)
+	{
+		for (int32 toCell = fromCell + 1; toCell < numCells; ++toCell)
+		{
+			if (getBit(1 + fromCell, toCell))
+			{
+				setBit(1 + toCell, fromCell);
+			}
+		}
+	}
+
+	OutData.Reset(sizeof(FCameleonVisibilityGridHeader) + sets.Num() * sizeof(uint32));
+	OutData.Append(reinterpret_cast<const uint8*>(&header), sizeof(FCameleonVisibilityGridHeader));
+	OutData.Append(reinterpret_cast<const uint8*>(sets.GetData()), sets.Num() * sizeof(uint32));
+}
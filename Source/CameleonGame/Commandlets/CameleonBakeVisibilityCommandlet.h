@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CameleonBakeVisibilityCommandlet.generated.h"
+
+// Bakes the visibility grid read by UCameleonVisibilitySubsystem for the given maps, run it headless with e.g. //
+//
+//   UE4Editor-Cmd CameleonGame -run=CameleonBakeVisibility -Map=/Game/FirstPersonCPP/Maps/FirstPersonExampleMap -nullrhi
+//
+// -Map=<Map>+<Map>     long package names of the maps to bake
+// -CellSize=400        edge of a cell in cm, grown when the level would need more than -MaxCells cells
+// -MaxCells=16384      the grid takes MaxCells^2 bits
+// -Samples=4           rays traced between each pair of cells, the first one between their centers
+// -MaxDistance=6000    pairs of cells further apart are assumed to see each other, they're never queried //
+UCLASS()
+class CAMELEONGAME_API UCameleonBakeVisibilityCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCameleonBakeVisibilityCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool BakeMap(const FString& MapPackageName) const;
+
+	// Traces the static geometry of the world, returns the grid laid out as FCameleonVisibilityGrid reads it //
+	void BakeGrid(UWorld* World, TArray<uint8>& OutData) const;
+
+	float CellSize = 400.f;
+
+	int32 MaxCells = 16384;
+
+	int32 NumSamples = 4;
+
+	float MaxDistance = 6000.f;
+};
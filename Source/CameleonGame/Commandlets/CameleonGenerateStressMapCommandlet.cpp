@@ -0,0 +1,301 @@
+#include "CameleonGenerateStressMapCommandlet.h"
+#include "CameleonGameCharacter.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/DirectionalLight.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerStart.h"
+#include "Math/RandomStream.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCameleonStressMap, Log, All);
+
+namespace CameleonStressMap
+{
+	const TCHAR* DefaultCharacterClass = TEXT("/Game/Cameleon/Characters/BaseCharacter.BaseCharacter_C");
+	const TCHAR* DefaultInteractableClass = TEXT("/Game/BPTestInteractable.BPTestInteractable_C");
+	const TCHAR* OccluderMesh = TEXT("/Game/Geometry/Meshes/1M_Cube.1M_Cube");
+
+	// Attempts to find a place that's not inside of an occluder before giving up and overlapping it //
+	const int32 MaxPlacementAttempts = 8;
+
+	// Nothing is placed this close to the player start //
+	const float PlayerStartClearance = 500.f;
+
+	struct FParams
+	{
+		FString MapPackageName;
+		int32 Seed = 1;
+		float Size = 20000.f;
+		int32 NumCharacters = 2000;
+		float ControllableRatio = 0.5f;
+		float SelfieRatio = 0.2f;
+		int32 NumInteractables = 200;
+		float OccluderDensity = 0.5f;
+		int32 NumClusters = 0;
+		float ClusterRadius = 1500.f;
+		FString CharacterClass = DefaultCharacterClass;
+		FString InteractableClass = DefaultInteractableClass;
+	};
+
+	// Footprint of an occluder on the floor //
+	struct FFootprint
+	{
+		FVector2D Center;
+		float Radius;
+	};
+
+	// Picks the places of the crowd and the interactables, spread uniformly or gathered in the clusters //
+	class FPlacement
+	{
+	public:
+		FPlacement(const FParams& InParams, FRandomStream& InRandomStream)
+			: Params(InParams)
+			, RandomStream(InRandomStream)
+		{
+			for (int32 clusterIdx = 0; clusterIdx < Params.NumClusters; ++clusterIdx)
+			{
+				ClusterCenters.Add(RandomPoint(Params.ClusterRadius));
+			}
+		}
+
+		FVector2D RandomPoint(const float Margin) const
+		{
+			const float halfSize = FMath::Max(0.f, Params.Size * 0.5f - Margin);
+			return {RandomStream.FRandRange(-halfSize, halfSize), RandomStream.FRandRange(-halfSize, halfSize)};
+		}
+
+		FVector2D Next(const TArray<FFootprint>& Occluders, const float Radius) const
+		{
+			FVector2D point;
+
+			for (int32 attemptIdx = 0; attemptIdx < MaxPlacementAttempts; ++attemptIdx)
+			{
+				if (ClusterCenters.Num() > 0)
+				{
+					// The sum of two uniform offsets gathers the points towards the center of the cluster
+					const auto& center = ClusterCenters[RandomStream.RandHelper(ClusterCenters.Num())];
+					const float offsetX = RandomStream.FRandRange(-0.5f, 0.5f) + RandomStream.FRandRange(-0.5f, 0.5f);
+					const float offsetY = RandomStream.FRandRange(-0.5f, 0.5f) + RandomStream.FRandRange(-0.5f, 0.5f);
+					point = center + FVector2D(offsetX, offsetY) * Params.ClusterRadius;
+
+					const float halfSize = Params.Size * 0.5f - Radius;
+					point.X = FMath::Clamp(point.X, -halfSize, halfSize);
+					point.Y = FMath::Clamp(point.Y, -halfSize, halfSize);
+				}
+				else
+				{
+					point = RandomPoint(Radius);
+				}
+
+				if (IsFree(point, Occluders, Radius))
+				{
+					break;
+				}
+			}
+
+			return point;
+		}
+
+		static bool IsFree(const FVector2D& Point, const TArray<FFootprint>& Occluders, const float Radius)
+		{
+			if (Point.SizeSquared() < FMath::Square(PlayerStartClearance))
+			{
+				return false;
+			}
+
+			for (const auto& occluder : Occluders)
+			{
+				if (FVector2D::DistSquared(Point, occluder.Center) < FMath::Square(occluder.Radius + Radius))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		const FParams& Params;
+
+		FRandomStream& RandomStream;
+
+		TArray<FVector2D> ClusterCenters;
+	};
+
+	// Places the mesh so that its bounds are centered on the location and have the given size //
+	AStaticMeshActor* SpawnBox(UWorld* World, UStaticMesh* Mesh, const FRotator& Rotation, const FVector& Center,
+	                           const FVector& Size)
+	{
+		const auto meshBounds = Mesh->GetBounds();
+		const auto scale = Size / (meshBounds.BoxExtent * 2.f).ComponentMax(FVector(KINDA_SMALL_NUMBER));
+		const auto location = Center - Rotation.RotateVector(meshBounds.Origin * scale);
+
+		auto actor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(),
+		                                                 FTransform(Rotation, location, scale));
+		if (actor)
+		{
+			actor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+		}
+
+		return actor;
+	}
+}
+
+UCameleonGenerateStressMapCommandlet::UCameleonGenerateStressMapCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UCameleonGenerateStressMapCommandlet::Main(const FString& Params)
+{
+	using namespace CameleonStressMap;
+
+#if WITH_EDITOR
+	FParams params;
+	FParse::Value(*Params, TEXT("Seed="), params.Seed);
+	FParse::Value(*Params, TEXT("Size="), params.Size);
+	FParse::Value(*Params, TEXT("Characters="), params.NumCharacters);
+	FParse::Value(*Params, TEXT("ControllableRatio="), params.ControllableRatio);
+	FParse::Value(*Params, TEXT("SelfieRatio="), params.SelfieRatio);
+	FParse::Value(*Params, TEXT("Interactables="), params.NumInteractables);
+	FParse::Value(*Params, TEXT("OccluderDensity="), params.OccluderDensity);
+	FParse::Value(*Params, TEXT("Clusters="), params.NumClusters);
+	FParse::Value(*Params, TEXT("ClusterRadius="), params.ClusterRadius);
+	FParse::Value(*Params, TEXT("CharacterClass="), params.CharacterClass);
+	FParse::Value(*Params, TEXT("InteractableClass="), params.InteractableClass);
+
+	params.MapPackageName = FString::Printf(TEXT("/Game/Cameleon/Maps/Stress/StressMap_%d"), params.Seed);
+	FParse::Value(*Params, TEXT("Map="), params.MapPackageName);
+
+	params.Size = FMath::Max(params.Size, 2.f * PlayerStartClearance + 100.f);
+
+	FString mapFilename;
+	if (!FPackageName::TryConvertLongPackageNameToFilename(params.MapPackageName, mapFilename,
+	                                                       FPackageName::GetMapPackageExtension()))
+	{
+		UE_LOG(LogCameleonStressMap, Error, TEXT("%s isn't a valid map name"), *params.MapPackageName);
+		return 1;
+	}
+
+	UClass* characterClass = LoadClass<ACameleonGameCharacter>(nullptr, *params.CharacterClass);
+	UClass* interactableClass = LoadClass<AActor>(nullptr, *params.InteractableClass);
+	UStaticMesh* occluderMesh = LoadObject<UStaticMesh>(nullptr, OccluderMesh);
+
+	if (!characterClass || !interactableClass || !occluderMesh)
+	{
+		UE_LOG(LogCameleonStressMap, Error, TEXT("Couldn't load %s, %s or %s"),
+		       *params.CharacterClass, *params.InteractableClass, OccluderMesh);
+		return 1;
+	}
+
+	const auto package = CreatePackage(nullptr, *params.MapPackageName);
+	const auto world = UWorld::CreateWorld(EWorldType::Editor, false,
+	                                       FName(*FPackageName::GetShortName(params.MapPackageName)), package);
+	world->SetFlags(RF_Public | RF_Standalone);
+
+	FRandomStream randomStream(params.Seed);
+	FPlacement placement(params, randomStream);
+
+	// Floor with its top at zero, the player starts in the middle of it
+
+	SpawnBox(world, occluderMesh, FRotator::ZeroRotator, FVector(0.f, 0.f, -50.f),
+	         FVector(params.Size, params.Size, 100.f));
+
+	world->SpawnActor<APlayerStart>(APlayerStart::StaticClass(), FTransform(FVector(0.f, 0.f, 100.f)));
+	world->SpawnActor<ADirectionalLight>(ADirectionalLight::StaticClass(),
+	                                     FTransform(FRotator(-45.f, 30.f, 0.f), FVector(0.f, 0.f, 1000.f)));
+
+	// Occluders
+
+	const int32 numOccluders = FMath::RoundToInt(FMath::Square(params.Size / 1000.f) * params.OccluderDensity);
+	TArray<FFootprint> occluders;
+	occluders.Reserve(numOccluders);
+
+	for (int32 occluderIdx = 0; occluderIdx < numOccluders; ++occluderIdx)
+	{
+		// Walls from one to four meters wide, taller than the characters
+		const FVector size(randomStream.FRandRange(100.f, 400.f),
+		                   randomStream.FRandRange(50.f, 200.f),
+		                   randomStream.FRandRange(200.f, 400.f));
+		const float radius = FVector2D(size.X, size.Y).Size() * 0.5f;
+		const FRotator rotation(0.f, randomStream.FRandRange(0.f, 180.f), 0.f);
+
+		const auto center = placement.RandomPoint(radius);
+		if (center.SizeSquared() < FMath::Square(PlayerStartClearance + radius))
+		{
+			continue;
+		}
+
+		SpawnBox(world, occluderMesh, rotation, FVector(center, size.Z * 0.5f), size);
+		occluders.Add({center, radius});
+	}
+
+	// Crowd
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const auto controllableTag = FGameplayTag::RequestGameplayTag("Controllable");
+	int32 numControllable = 0;
+
+	for (int32 characterIdx = 0; characterIdx < params.NumCharacters; ++characterIdx)
+	{
+		const auto point = placement.Next(occluders, 50.f);
+		const FRotator rotation(0.f, randomStream.FRandRange(-180.f, 180.f), 0.f);
+
+		auto character = world->SpawnActor<ACameleonGameCharacter>(characterClass, FVector(point, 100.f), rotation,
+		                                                            spawnParameters);
+		if (!character)
+		{
+			continue;
+		}
+
+		if (randomStream.FRand() < params.ControllableRatio)
+		{
+			character->AddGameplayTag(controllableTag);
+			++numControllable;
+		}
+
+		character->CrowdPose = randomStream.FRand() < params.SelfieRatio ? ECameleonCrowdPose::Selfie
+		                                                                  : ECameleonCrowdPose::Idle;
+	}
+
+	// Interactables
+
+	for (int32 interactableIdx = 0; interactableIdx < params.NumInteractables; ++interactableIdx)
+	{
+		const auto point = placement.Next(occluders, 50.f);
+		world->SpawnActor<AActor>(interactableClass, FVector(point, 50.f), FRotator::ZeroRotator, spawnParameters);
+	}
+
+	const bool bSaved = UPackage::SavePackage(package, world, RF_NoFlags, *mapFilename, GError, nullptr, false, true,
+	                                          SAVE_NoError);
+
+	world->DestroyWorld(false);
+	world->RemoveFromRoot();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	if (!bSaved)
+	{
+		UE_LOG(LogCameleonStressMap, Error, TEXT("Couldn't save %s"), *mapFilename);
+		return 1;
+	}
+
+	UE_LOG(LogCameleonStressMap, Display,
+	       TEXT("Generated %s with the seed %d: %d characters (%d controllable), %d interactables, %d occluders"),
+	       *params.MapPackageName, params.Seed, params.NumCharacters, numControllable, params.NumInteractables,
+	       occluders.Num());
+
+	return 0;
+#else
+	UE_LOG(LogCameleonStressMap, Error, TEXT("The stress maps can only be generated by the editor"));
+	return 1;
+#endif
+}
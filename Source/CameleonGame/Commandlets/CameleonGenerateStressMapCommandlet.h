@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CameleonGenerateStressMapCommandlet.generated.h"
+
+// Generates a reproducible stress test map from a seed, the same parameters give the same map on every machine. //
+// Run it headless with e.g. //
+//
+//   UE4Editor-Cmd CameleonGame -run=CameleonGenerateStressMap -Seed=7 -Characters=5000 -nullrhi
+//
+// -Map=/Game/Cameleon/Maps/Stress/StressMap_<Seed>   long package name of the generated map
+// -Seed=1                    seed of the placement
+// -Size=20000                edge of the square area in cm, the floor covers it
+// -Characters=2000           crowd size
+// -ControllableRatio=0.5     share of the crowd tagged Controllable
+// -SelfieRatio=0.2           share of the crowd posing for a selfie instead of standing idle
+// -Interactables=200
+// -OccluderDensity=0.5       1M_Cube occluders per 100 square meters
+// -Clusters=0                number of clusters the crowd and the interactables gather in, 0 to spread them uniformly
+// -ClusterRadius=1500
+// -CharacterClass=, -InteractableClass=   classes to place instead of the project's blueprints
+//
+// The maps can be replayed against with -CameleonReplaySession or baked with -run=CameleonBakeVisibility //
+UCLASS()
+class CAMELEONGAME_API UCameleonGenerateStressMapCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCameleonGenerateStressMapCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
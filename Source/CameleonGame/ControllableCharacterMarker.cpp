@@ -16,6 +16,10 @@ AControllableCharacterMarker::AControllableCharacterMarker()
 
 	MeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MeshComponent"));
 	MeshComponent->SetupAttachment(RootComponent);
+
+	// Cosmetic, spawned by the owning client for its own candidates
+	bReplicates = false;
+	bNetLoadOnClient = false;
 }
 
 void AControllableCharacterMarker::SetActive(const bool& Active)
@@ -23,6 +27,20 @@ void AControllableCharacterMarker::SetActive(const bool& Active)
 	MeshComponent->SetMaterial(0, Active ? ActiveMaterial : DefaultMaterial);
 }
 
+void AControllableCharacterMarker::OnAcquired(AActor* Character, const FVector& RelativeLocation)
+{
+	AttachToActor(Character, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	SetActorRelativeLocation(RelativeLocation);
+	SetActorHiddenInGame(false);
+	SetActive(false);
+}
+
+void AControllableCharacterMarker::OnReleased()
+{
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	SetActorHiddenInGame(true);
+}
+
 // Called when the game starts
 void AControllableCharacterMarker::BeginPlay()
 {
@@ -5,6 +5,16 @@
 #include "CoreMinimal.h"
 #include "ControllableCharacterMarker.generated.h"
 
+// How the markers above the controllable characters are rendered //
+UENUM()
+enum class ECameleonMarkerMode : uint8
+{
+	// Every marker is a separate, pooled AControllableCharacterMarker actor //
+	Actors,
+	// All of the markers are instances of a single instanced static mesh component, //
+	// the highlight is passed to the material through the per-instance custom data //
+	Instanced
+};
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class CAMELEONGAME_API AControllableCharacterMarker : public AActor
@@ -32,6 +42,12 @@ public:
 
 	void SetActive(const bool& Active);
 
+	// Called by the marker pool when the marker is handed out for the character //
+	void OnAcquired(AActor* Character, const FVector& RelativeLocation);
+
+	// Called by the marker pool when the marker is returned to it //
+	void OnReleased();
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
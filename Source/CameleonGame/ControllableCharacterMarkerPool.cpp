@@ -0,0 +1,96 @@
+#include "ControllableCharacterMarkerPool.h"
+#include "ControllableCharacterMarker.h"
+#include "Engine/World.h"
+
+void UControllableCharacterMarkerPool::Initialize(TSubclassOf<AControllableCharacterMarker> InMarkerClass,
+                                                  const int32 PrewarmSize)
+{
+	MarkerClass = InMarkerClass;
+
+	FreeMarkers.Reserve(PrewarmSize);
+	for (int32 markerIdx = 0; markerIdx < PrewarmSize; ++markerIdx)
+	{
+		if (auto marker = SpawnMarker())
+		{
+			marker->OnReleased();
+			FreeMarkers.Add(marker);
+		}
+	}
+
+	Stats.NumFree = FreeMarkers.Num();
+}
+
+AControllableCharacterMarker* UControllableCharacterMarkerPool::Acquire(AActor* Character,
+                                                                        const FVector& RelativeLocation)
+{
+	AControllableCharacterMarker* marker = nullptr;
+
+	// Skip the markers that got destroyed behind our back, e.g. when the level was unloaded
+	while (!marker && FreeMarkers.Num() > 0)
+	{
+		marker = FreeMarkers.Pop(false);
+		marker = IsValid(marker) ? marker : nullptr;
+	}
+
+	if (marker)
+	{
+		++Stats.Hits;
+	}
+	else
+	{
+		++Stats.Misses;
+		marker = SpawnMarker();
+	}
+
+	if (!marker)
+	{
+		return nullptr;
+	}
+
+	marker->OnAcquired(Character, RelativeLocation);
+
+	++Stats.NumInUse;
+	Stats.NumFree = FreeMarkers.Num();
+	Stats.HighWaterMark = FMath::Max(Stats.HighWaterMark, Stats.NumInUse);
+
+	return marker;
+}
+
+void UControllableCharacterMarkerPool::Release(AControllableCharacterMarker* Marker)
+{
+	if (!IsValid(Marker))
+	{
+		return;
+	}
+
+	Marker->OnReleased();
+	FreeMarkers.Add(Marker);
+
+	--Stats.NumInUse;
+	Stats.NumFree = FreeMarkers.Num();
+}
+
+void UControllableCharacterMarkerPool::Empty()
+{
+	for (auto marker : FreeMarkers)
+	{
+		if (IsValid(marker))
+		{
+			marker->Destroy();
+		}
+	}
+
+	FreeMarkers.Empty();
+	Stats.NumFree = 0;
+}
+
+AControllableCharacterMarker* UControllableCharacterMarkerPool::SpawnMarker()
+{
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AControllableCharacterMarker>(MarkerClass,
+	                                                            FVector::ZeroVector,
+	                                                            FRotator::ZeroRotator,
+	                                                            spawnParameters);
+}
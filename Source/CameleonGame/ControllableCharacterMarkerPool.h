@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "ControllableCharacterMarkerPool.generated.h"
+
+class AControllableCharacterMarker;
+
+USTRUCT(BlueprintType)
+struct FControllableCharacterMarkerPoolStats
+{
+	GENERATED_BODY()
+
+	// Number of markers handed out from the pool //
+	UPROPERTY(BlueprintReadOnly, Category = Marker)
+	int32 Hits = 0;
+
+	// Number of markers that had to be spawned because the pool was empty //
+	UPROPERTY(BlueprintReadOnly, Category = Marker)
+	int32 Misses = 0;
+
+	// Largest number of markers in use at the same time //
+	UPROPERTY(BlueprintReadOnly, Category = Marker)
+	int32 HighWaterMark = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Marker)
+	int32 NumInUse = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Marker)
+	int32 NumFree = 0;
+};
+
+// Keeps the markers around once they're not needed anymore so we don't spawn and destroy them //
+// every time a character enters or leaves the player's sight //
+UCLASS()
+class CAMELEONGAME_API UControllableCharacterMarkerPool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Spawns PrewarmSize markers of the given class upfront //
+	void Initialize(TSubclassOf<AControllableCharacterMarker> InMarkerClass, int32 PrewarmSize);
+
+	// Attaches a marker to the character, spawns a new one only if there are no free markers //
+	AControllableCharacterMarker* Acquire(AActor* Character, const FVector& RelativeLocation);
+
+	// Returns the marker to the pool, it's detached and hidden //
+	void Release(AControllableCharacterMarker* Marker);
+
+	// Destroys all of the free markers //
+	void Empty();
+
+	const FControllableCharacterMarkerPoolStats& GetStats() const
+	{
+		return Stats;
+	}
+
+private:
+	AControllableCharacterMarker* SpawnMarker();
+
+	UPROPERTY()
+	TSubclassOf<AControllableCharacterMarker> MarkerClass;
+
+	UPROPERTY()
+	TArray<AControllableCharacterMarker*> FreeMarkers;
+
+	FControllableCharacterMarkerPoolStats Stats;
+};
@@ -1 +1,101 @@
-#include "Interactable.h"
\ No newline at end of file
+#include "Interactable.h"
+#include "InteractableBase.h"
+#include "UObject/ObjectKey.h"
+
+// Functions of the interface, one bit each in the masks below
+enum class EInteractableFunction : uint8
+{
+	GetInteractableLocation,
+	Interact,
+	SetInteractableActive,
+	IsUseable,
+	Num
+};
+
+// Returns true if the function resolves to the native implementation for the class, cached per class
+// since finding the function is a map lookup per class in the hierarchy
+static bool IsNativeImplementation(const UClass* Class, const EInteractableFunction Function)
+{
+	static TMap<FObjectKey, uint8> nativeFunctionMasks;
+
+	if (const auto nativeFunctionMask = nativeFunctionMasks.Find(Class))
+	{
+		return (*nativeFunctionMask & (1 << static_cast<uint8>(Function))) != 0;
+	}
+
+	static const FName functionNames[] = {
+		GET_FUNCTION_NAME_CHECKED(IInteractable, GetInteractableLocation),
+		GET_FUNCTION_NAME_CHECKED(IInteractable, Interact),
+		GET_FUNCTION_NAME_CHECKED(IInteractable, SetInteractableActive),
+		GET_FUNCTION_NAME_CHECKED(IInteractable, IsUseable)
+	};
+	static_assert(UE_ARRAY_COUNT(functionNames) == static_cast<int32>(EInteractableFunction::Num),
+		"Every function of the interface needs its name");
+
+	// A Blueprint override is a script function found before the interface's native one
+
+	uint8 nativeFunctionMask = 0;
+	for (int32 functionIdx = 0; functionIdx < UE_ARRAY_COUNT(functionNames); ++functionIdx)
+	{
+		const auto function = Class->FindFunctionByName(functionNames[functionIdx]);
+		if (function && function->HasAnyFunctionFlags(FUNC_Native))
+		{
+			nativeFunctionMask |= 1 << functionIdx;
+		}
+	}
+
+	nativeFunctionMasks.Add(Class, nativeFunctionMask);
+	return (nativeFunctionMask & (1 << static_cast<uint8>(Function))) != 0;
+}
+
+FVector FInteractableCalls::GetInteractableLocation(const UObject* Interactable)
+{
+	const auto nativeInteractable = Cast<IInteractable>(Interactable);
+	if (nativeInteractable && IsNativeImplementation(Interactable->GetClass(), EInteractableFunction::GetInteractableLocation))
+	{
+		return nativeInteractable->GetInteractableLocation_Implementation();
+	}
+
+	return IInteractable::Execute_GetInteractableLocation(Interactable);
+}
+
+void FInteractableCalls::Interact(UObject* Interactable)
+{
+	const auto nativeInteractable = Cast<IInteractable>(Interactable);
+	if (nativeInteractable && IsNativeImplementation(Interactable->GetClass(), EInteractableFunction::Interact))
+	{
+		nativeInteractable->Interact_Implementation();
+		return;
+	}
+
+	IInteractable::Execute_Interact(Interactable);
+}
+
+void FInteractableCalls::SetInteractableActive(UObject* Interactable, const bool Active)
+{
+	const auto nativeInteractable = Cast<IInteractable>(Interactable);
+	if (nativeInteractable && IsNativeImplementation(Interactable->GetClass(), EInteractableFunction::SetInteractableActive))
+	{
+		nativeInteractable->SetInteractableActive_Implementation(Active);
+		return;
+	}
+
+	IInteractable::Execute_SetInteractableActive(Interactable, Active);
+}
+
+bool FInteractableCalls::IsUseable(const UObject* Interactable)
+{
+	const auto nativeInteractable = Cast<IInteractable>(Interactable);
+	if (nativeInteractable && IsNativeImplementation(Interactable->GetClass(), EInteractableFunction::IsUseable))
+	{
+		return nativeInteractable->IsUseable_Implementation();
+	}
+
+	return IInteractable::Execute_IsUseable(Interactable);
+}
+
+bool FInteractableCalls::ReportsUseableChanges(const UObject* Interactable)
+{
+	return Interactable->IsA<AInteractableBase>() &&
+		IsNativeImplementation(Interactable->GetClass(), EInteractableFunction::IsUseable);
+}
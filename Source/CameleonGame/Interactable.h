@@ -11,21 +11,40 @@ class UInteractable : public UInterface
 	GENERATED_BODY()
 };
 
+// Implemented either in Blueprint or in C++, see AInteractableBase. The hot paths call it through //
+// FInteractableCalls so the native implementations don't go through the Blueprint VM //
 class IInteractable
 {
 	GENERATED_BODY()
 
 public:
 
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	FVector GetInteractableLocation() const;
 
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	void Interact();
 
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
     void SetInteractableActive(bool Active);
 
-	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
     bool IsUseable() const;
 };
+
+// Calls the interactable's C++ implementation directly when its class implements the interface natively //
+// and doesn't override the function in Blueprint, falls back to Execute_ and the Blueprint VM otherwise //
+struct CAMELEONGAME_API FInteractableCalls
+{
+	static FVector GetInteractableLocation(const UObject* Interactable);
+
+	static void Interact(UObject* Interactable);
+
+	static void SetInteractableActive(UObject* Interactable, bool Active);
+
+	static bool IsUseable(const UObject* Interactable);
+
+	// Does the interactable report the changes of its useable state, which is the case for AInteractableBase //
+	// unless IsUseable() is overridden in Blueprint. The useable state of the others can't be cached //
+	static bool ReportsUseableChanges(const UObject* Interactable);
+};
@@ -0,0 +1,91 @@
+#include "InteractableBase.h"
+#include "CameleonInteractableSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+
+AInteractableBase::AInteractableBase()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void AInteractableBase::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	CachedInteractableLocation = GetActorTransform().TransformPosition(InteractableOffset);
+
+	// Keep the cached location up to date instead of computing it whenever it's asked for
+	if (RootComponent)
+	{
+		RootMovedHandle = RootComponent->TransformUpdated.AddUObject(this, &AInteractableBase::OnRootMoved);
+	}
+}
+
+void AInteractableBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (RootComponent)
+	{
+		RootComponent->TransformUpdated.Remove(RootMovedHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AInteractableBase::OnRootMoved(USceneComponent* UpdatedComponent,
+                                    EUpdateTransformFlags UpdateTransformFlags,
+                                    ETeleportType Teleport)
+{
+	CachedInteractableLocation = UpdatedComponent->GetComponentTransform().TransformPosition(InteractableOffset);
+}
+
+void AInteractableBase::SetUseable(const bool bInUseable)
+{
+	if (bUseable == bInUseable)
+	{
+		return;
+	}
+
+	bUseable = bInUseable;
+
+	// The players have to pick their focus again
+	if (auto interactableSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UCameleonInteractableSubsystem>() : nullptr)
+	{
+		interactableSubsystem->NotifyInteractableChanged(this);
+	}
+}
+
+FVector AInteractableBase::GetInteractableLocation_Implementation() const
+{
+	return CachedInteractableLocation;
+}
+
+void AInteractableBase::Interact_Implementation()
+{
+	if (!bUseable)
+	{
+		return;
+	}
+
+	OnInteract();
+
+	if (bSingleUse)
+	{
+		SetUseable(false);
+	}
+}
+
+void AInteractableBase::SetInteractableActive_Implementation(const bool Active)
+{
+	if (bInteractableActive != Active)
+	{
+		bInteractableActive = Active;
+		OnInteractableActiveChanged(Active);
+	}
+}
+
+bool AInteractableBase::IsUseable_Implementation() const
+{
+	return bUseable;
+}
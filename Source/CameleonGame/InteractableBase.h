@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Interactable.h"
+#include "InteractableBase.generated.h"
+
+// Native interactable, its location and useable state are cached so the players can focus it without going //
+// through the Blueprint VM. The Blueprint subclasses react to OnInteract() and OnInteractableActiveChanged() //
+// instead of overriding the interface, which would take them off the native path //
+UCLASS(Blueprintable)
+class CAMELEONGAME_API AInteractableBase : public AActor, public IInteractable
+{
+	GENERATED_BODY()
+
+public:
+	AInteractableBase();
+
+	UFUNCTION(BlueprintCallable)
+	void SetUseable(bool bInUseable);
+
+	UFUNCTION(BlueprintPure)
+	bool IsInteractableActive() const
+	{
+		return bInteractableActive;
+	}
+
+	// IInteractable interface
+
+	virtual FVector GetInteractableLocation_Implementation() const override;
+	virtual void Interact_Implementation() override;
+	virtual void SetInteractableActive_Implementation(bool Active) override;
+	virtual bool IsUseable_Implementation() const override;
+
+	// End of IInteractable interface
+
+protected:
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnInteract();
+
+	// Called when a player starts or stops focusing the interactable //
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnInteractableActiveChanged(bool bActive);
+
+	// Point the players focus, relative to the actor //
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FVector InteractableOffset = FVector::ZeroVector;
+
+	// Can the interactable be used, change it with SetUseable() //
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bUseable = true;
+
+	// Should the interactable stop being useable once it's been used //
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bSingleUse = false;
+
+private:
+	void OnRootMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags,
+	                 ETeleportType Teleport);
+
+	FVector CachedInteractableLocation = FVector::ZeroVector;
+
+	bool bInteractableActive = false;
+
+	FDelegateHandle RootMovedHandle;
+};
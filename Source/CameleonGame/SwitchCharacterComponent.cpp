@@ -1,8 +1,69 @@
 #include "SwitchCharacterComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "ControllableCharacterMarker.h"
+#include "ControllableCharacterMarkerPool.h"
+#include "Interactable.h"
+#include "CameleonGameCharacter.h"
+#include "CameleonInteractableSubsystem.h"
+#include "CameleonScanSubsystem.h"
+#include "CameleonVisibilitySubsystem.h"
+#include "CameleonProfiling.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "TimerManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCameleonNet, Log, All);
 
 USwitchCharacterComponent::USwitchCharacterComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
+
+	// Enabled only while there's some work to do, see UpdateTickEnabled()
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	// The transition, possession and scan change the actors, they're done before the physics. The interactables
+	// are snapshotted and scored on a worker thread alongside the physics, the picked one is applied after it
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	InteractableScoringTickFunction.TickGroup = TG_DuringPhysics;
+	InteractableScoringTickFunction.bCanEverTick = true;
+	InteractableScoringTickFunction.bStartWithTickEnabled = false;
+
+	InteractableFocusTickFunction.TickGroup = TG_PostPhysics;
+	InteractableFocusTickFunction.bCanEverTick = true;
+	InteractableFocusTickFunction.bStartWithTickEnabled = false;
+
+	bCanSwitch = true;
+	bScanActive = false;
+
+	SetIsReplicatedByDefault(true);
+}
+
+void USwitchCharacterComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Compared only when marked dirty on the engines built with WITH_PUSH_MODEL and Net.IsPushModelEnabled on,
+	// on every update like any other property otherwise. The marking compiles away without push model
+	FDoRepLifetimeParams params;
+	params.bIsPushBased = true;
+	params.Condition = COND_OwnerOnly;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(USwitchCharacterComponent, SwitchState, params);
+}
+
+bool USwitchCharacterComponent::IsLocallyControlled() const
+{
+	return PlayerController && PlayerController->IsLocalController();
 }
 
 
@@ -10,11 +71,1459 @@ USwitchCharacterComponent::USwitchCharacterComponent()
 void USwitchCharacterComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	PlayerController = Cast<APlayerController>(GetOwner());
+	check(PlayerController);
+
+	auto queryExpression = FGameplayTagQueryExpression()
+		.AllTagsMatch()
+		.AddTag(FGameplayTag::RequestGameplayTag("Controllable"));
+
+	ControllableCharacterQuery.Build(queryExpression);
+
+	// The scan subsystem keeps track of the characters matching the query as their tags change
+	if (auto scanSubsystem = GetWorld()->GetSubsystem<UCameleonScanSubsystem>())
+	{
+		ControllableQueryIndex = scanSubsystem->RegisterQuery(ControllableCharacterQuery);
+	}
+
+	ScanVolume = NewObject<UBoxComponent>(GetOwner(), TEXT("ScanVolume"));
+	ScanVolume->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ScanVolume->SetGenerateOverlapEvents(false);
+	ScanVolume->SetBoxExtent(ScanDistance);
+	ScanVolume->RegisterComponent();
+
+	AttachToPossessedCharacter();
+
+	//@TODO Remove once we have some nice effect to show the scan region
+	GetOwner()->SetActorHiddenInGame(false);
+	ScanVolume->SetHiddenInGame(true);
+
+	// The traffic is measured on the server for the remote players
+	if (GetOwnerRole() == ROLE_Authority && !IsLocallyControlled())
+	{
+		GetWorld()->GetTimerManager().SetTimer(NetStatsTimerHandle, this, &USwitchCharacterComponent::UpdateNetStats,
+		                                       1.f, true);
+	}
+
+	// Markers are cosmetic, they're spawned only by the owning client and never replicated
+	if (!IsLocallyControlled())
+	{
+		return;
+	}
+
+	// The interactables coming within the reach wake the tick up
+	GetWorld()->GetTimerManager().SetTimer(InteractableProximityTimerHandle, this,
+	                                       &USwitchCharacterComponent::UpdateInteractablesInReach,
+	                                       InteractableProximityInterval, true);
+
+	MarkerPool = NewObject<UControllableCharacterMarkerPool>(this);
+	MarkerPool->Initialize(MarkerClass, MarkerMode == ECameleonMarkerMode::Actors ? MarkerPoolSize : 0);
+
+	if (MarkerMode == ECameleonMarkerMode::Instanced)
+	{
+		MarkerInstances = NewObject<UInstancedStaticMeshComponent>(GetOwner(), TEXT("MarkerInstances"));
+		MarkerInstances->SetUsingAbsoluteLocation(true);
+		MarkerInstances->SetUsingAbsoluteRotation(true);
+		MarkerInstances->SetUsingAbsoluteScale(true);
+		MarkerInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		MarkerInstances->SetCastShadow(false);
+		MarkerInstances->NumCustomDataFloats = 1;
+		MarkerInstances->SetStaticMesh(InstancedMarkerMesh);
+		MarkerInstances->SetMaterial(0, InstancedMarkerMaterial);
+		MarkerInstances->RegisterComponent();
+	}
+}
+
+void USwitchCharacterComponent::AttachToPossessedCharacter()
+{
+	if (!ScanVolume)
+	{
+		return;
+	}
+
+	if (const auto character = PlayerController->GetCharacter())
+	{
+		if (const auto camera = character->FindComponentByClass<UCameraComponent>())
+		{
+			CurrentCharacterCamera = camera;
+			ScanVolume->AttachToComponent(camera, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+			ScanVolume->SetRelativeLocation({ScanDistance.X / 2, 0, ScanDistance.Z / 2});
+
+			// The view target of a transition is already set
+			if (!bInTransition)
+			{
+				PlayerController->SetViewTarget(character);
+			}
+		}
+	}
+}
+
+void USwitchCharacterComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetTimerManager().ClearTimer(NetStatsTimerHandle);
+	GetWorld()->GetTimerManager().ClearTimer(InteractableProximityTimerHandle);
+
+	// The task may still be reading the snapshot
+	WaitForInteractableFocusTask();
+	SetActiveInteractable(nullptr);
+
+	if (MarkerPool)
+	{
+		ClearControllableCharacters();
+		MarkerPool->Empty();
+	}
+
+	if (auto scanSubsystem = GetWorld()->GetSubsystem<UCameleonScanSubsystem>())
+	{
+		scanSubsystem->UnregisterQuery(ControllableQueryIndex);
+		ControllableQueryIndex = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 
 void USwitchCharacterComponent::TickComponent(float DeltaTime, ELevelTick TickType,
                                               FActorComponentTickFunction* ThisTickFunction)
 {
+	CAMELEON_PROFILE_SCOPE(Tick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-}
\ No newline at end of file
+
+	// Camera transition
+	if (bInTransition)
+	{
+		UpdateTransition(DeltaTime);
+	}
+
+	// Scan volume, only the owning client scans
+
+	if (bScanActive && !bInTransition && IsLocallyControlled())
+	{
+		if (IsStageDue(TimeSinceScan, ScanInterval, DeltaTime))
+		{
+			UpdateScanVolume();
+		}
+
+		DispatchVisibilityChecks();
+
+		if (IsStageDue(TimeSinceRank, RankInterval, DeltaTime))
+		{
+			RankCharactersInSight();
+		}
+
+		if (IsStageDue(TimeSinceSwitchValidation, SwitchValidationInterval, DeltaTime))
+		{
+			ValidateSwitchTargets();
+		}
+
+		// The switch requested before the validation of the active target was fresh enough
+		if (bSwitchRequested)
+		{
+			TryStartTransition();
+		}
+	}
+
+	if (MarkerInstances)
+	{
+		UpdateInstancedMarkers();
+	}
+
+	// Interactables
+
+	if (!bInTransition && IsLocallyControlled() && IsStageDue(TimeSinceInteractableFocus, InteractableFocusInterval, DeltaTime))
+	{
+		if (bAsyncInteractableFocus)
+		{
+			bInteractableFocusDue = true;
+		}
+		else
+		{
+			UpdateInteractableFocus();
+		}
+	}
+
+	UpdateStats();
+}
+
+void USwitchCharacterComponent::RegisterComponentTickFunctions(const bool bRegister)
+{
+	Super::RegisterComponentTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		// Scores what the component's tick has found due, the result is applied in the same frame
+
+		if (SetupActorComponentTickFunction(&InteractableScoringTickFunction))
+		{
+			InteractableScoringTickFunction.Target = this;
+			InteractableScoringTickFunction.AddPrerequisite(this, PrimaryComponentTick);
+		}
+
+		if (SetupActorComponentTickFunction(&InteractableFocusTickFunction))
+		{
+			InteractableFocusTickFunction.Target = this;
+			InteractableFocusTickFunction.AddPrerequisite(this, InteractableScoringTickFunction);
+		}
+	}
+	else
+	{
+		if (InteractableScoringTickFunction.IsTickFunctionRegistered())
+		{
+			InteractableScoringTickFunction.UnRegisterTickFunction();
+		}
+
+		if (InteractableFocusTickFunction.IsTickFunctionRegistered())
+		{
+			InteractableFocusTickFunction.UnRegisterTickFunction();
+		}
+	}
+}
+
+void USwitchCharacterComponent::UpdateTransition(const float DeltaTime)
+{
+	// The clients wait for the server to finish the transition
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	TransitionTimer += DeltaTime;
+
+	if (TransitionTimer > TransitionTimeSeconds)
+	{
+		PlayerController->Possess(SwitchState.Target);
+
+		SwitchState.bInTransition = false;
+		MARK_PROPERTY_DIRTY_FROM_NAME(USwitchCharacterComponent, SwitchState, this);
+
+		FinishTransition();
+	}
+}
+
+void USwitchCharacterComponent::FinishTransition()
+{
+	if (IsLocallyControlled())
+	{
+		PlayerController->EnableInput(PlayerController);
+	}
+
+	ClearControllableCharacters();
+
+	bInTransition = false;
+	bCanSwitch = true;
+
+	// The interactables are shared by the whole world, only the focus is picked again for the new character
+	SetActiveInteractable(nullptr);
+	bInteractableFocusDirty = true;
+
+	bScanActive = true;
+	ScanVolume->SetHiddenInGame(!bDrawScanVolume || !IsLocallyControlled());
+
+	TimeSinceScan = ScanInterval;
+	TimeSinceRank = RankInterval;
+	TimeSinceSwitchValidation = SwitchValidationInterval;
+
+	UpdateTickEnabled();
+}
+
+void USwitchCharacterComponent::OnRep_SwitchState()
+{
+	if (SwitchState.bInTransition && !bInTransition)
+	{
+		EnterTransition();
+	}
+	else if (!SwitchState.bInTransition && bInTransition)
+	{
+		FinishTransition();
+	}
+}
+
+void USwitchCharacterComponent::UpdateNetStats()
+{
+	const auto connection = PlayerController->GetNetConnection();
+	if (!connection)
+	{
+		return;
+	}
+
+	NetStats.InBytesPerSecond = connection->InBytesPerSecond;
+	NetStats.OutBytesPerSecond = connection->OutBytesPerSecond;
+
+	const int32 playerId = PlayerController->PlayerState ? PlayerController->PlayerState->GetPlayerId() : INDEX_NONE;
+
+#if CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(*FString::Printf(TEXT("Player%d_InBytesPerSecond"), playerId),
+	                               CSV_CATEGORY_INDEX(Cameleon), NetStats.InBytesPerSecond, ECsvCustomStatOp::Set);
+	FCsvProfiler::RecordCustomStat(*FString::Printf(TEXT("Player%d_OutBytesPerSecond"), playerId),
+	                               CSV_CATEGORY_INDEX(Cameleon), NetStats.OutBytesPerSecond, ECsvCustomStatOp::Set);
+#endif
+
+	UE_LOG(LogCameleonNet, Verbose, TEXT("Player %d: in %d B/s, out %d B/s"),
+	       playerId, NetStats.InBytesPerSecond, NetStats.OutBytesPerSecond);
+}
+
+void USwitchCharacterComponent::UpdateInteractablesInReach()
+{
+	const auto playerCharacter = PlayerController->GetCharacter();
+	const auto interactableSubsystem = GetWorld()->GetSubsystem<UCameleonInteractableSubsystem>();
+
+	InteractablesInReach.Reset();
+
+	if (playerCharacter && interactableSubsystem)
+	{
+		FVector eyesPos;
+		FRotator viewRotation;
+		playerCharacter->GetActorEyesViewPoint(eyesPos, viewRotation);
+
+		interactableSubsystem->QueryInteractables(eyesPos, InteractableReach, InteractablesInReach);
+	}
+
+	const bool bInReach = InteractablesInReach.Num() > 0;
+	if (bInReach == bInteractablesInReach)
+	{
+		return;
+	}
+
+	bInteractablesInReach = bInReach;
+
+	// The focus isn't updated anymore once the tick stops
+	if (!bInReach)
+	{
+		SetActiveInteractable(nullptr);
+		bInteractableFocusDirty = true;
+	}
+
+	UpdateTickEnabled();
+}
+
+void USwitchCharacterComponent::UpdateInteractableFocus()
+{
+	CAMELEON_PROFILE_SCOPE(InteractableFocus);
+
+	auto playerCharacter = PlayerController->GetCharacter();
+	auto interactableSubsystem = GetWorld()->GetSubsystem<UCameleonInteractableSubsystem>();
+
+	if (!playerCharacter || !interactableSubsystem)
+	{
+		return;
+	}
+
+	// Find the interactable within the reach that the player is facing by calculating the dot product
+	// of the eye vector and the direction to the interactable
+
+	FVector eyesPos;
+	FRotator viewRotation;
+	playerCharacter->GetActorEyesViewPoint(eyesPos, viewRotation);
+
+	auto eyeVector = CurrentCharacterCamera->GetForwardVector();
+
+	// Nothing to do if neither the view nor the interactables have changed since the last update
+
+	const bool bFocusChanged = bInteractableFocusDirty ||
+		!eyesPos.Equals(LastFocusEyesPosition) ||
+		!eyeVector.Equals(LastFocusEyeVector) ||
+		interactableSubsystem->GetVersion() != LastFocusInteractablesVersion;
+
+	if (!bFocusChanged)
+	{
+		return;
+	}
+
+	LastFocusEyesPosition = eyesPos;
+	LastFocusEyeVector = eyeVector;
+	LastFocusInteractablesVersion = interactableSubsystem->GetVersion();
+	bInteractableFocusDirty = false;
+
+	if (!bAsyncInteractableFocus)
+	{
+		SetActiveInteractable(interactableSubsystem->FindMostFaced(eyesPos, eyeVector, InteractableReach));
+		return;
+	}
+
+	// Only the scoring of the copied locations runs on the worker thread, the actors aren't touched there.
+	// The previous task is normally done with in TG_PostPhysics, unless that tick got disabled meanwhile
+
+	WaitForInteractableFocusTask();
+
+	interactableSubsystem->SnapshotInteractables(eyesPos, eyeVector, InteractableReach, InteractableSnapshot);
+
+	InteractableFocusTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this]()
+	{
+		InteractableFocusResult = InteractableSnapshot.FindMostFaced();
+	}, TStatId(), nullptr, ENamedThreads::AnyThread);
+}
+
+void USwitchCharacterComponent::DispatchInteractableFocus()
+{
+	if (!bInteractableFocusDue)
+	{
+		return;
+	}
+
+	bInteractableFocusDue = false;
+
+	// The transition may have started after the update was found due
+	if (!bInTransition)
+	{
+		UpdateInteractableFocus();
+	}
+}
+
+bool USwitchCharacterComponent::WaitForInteractableFocusTask()
+{
+	if (!InteractableFocusTask.IsValid())
+	{
+		return false;
+	}
+
+	FTaskGraphInterface::Get().WaitUntilTaskCompletes(InteractableFocusTask, ENamedThreads::GameThread);
+	InteractableFocusTask = nullptr;
+
+	return true;
+}
+
+void USwitchCharacterComponent::ApplyInteractableFocus()
+{
+	if (!WaitForInteractableFocusTask())
+	{
+		return;
+	}
+
+	CAMELEON_PROFILE_SCOPE(InteractableFocus);
+
+	// The picked interactable is stale if the focus was reset or a transition started since the snapshot
+
+	auto interactable = InteractableFocusResult;
+	InteractableFocusResult = nullptr;
+
+	if (bInteractableFocusDirty || bInTransition)
+	{
+		return;
+	}
+
+	SetActiveInteractable(IsValid(interactable) ? interactable : nullptr);
+}
+
+void USwitchCharacterComponent::SetActiveInteractable(AActor* aInteractable)
+{
+	if (aInteractable == ActiveAInteractable)
+	{
+		return;
+	}
+
+	// disable the last interactable if we had one
+	if (IsValid(ActiveAInteractable))
+	{
+		FInteractableCalls::SetInteractableActive(ActiveAInteractable, false);
+	}
+
+	// enable the newly picked one
+	if (aInteractable)
+	{
+		FInteractableCalls::SetInteractableActive(aInteractable, true);
+	}
+
+	ActiveAInteractable = aInteractable;
+}
+
+void USwitchCharacterComponent::UpdateTickEnabled()
+{
+	// The server only advances the transitions of the remote players, the owning client scans and focuses
+	// the interactables within its reach
+
+	const bool bFocusInteractables = IsLocallyControlled() && (bInteractablesInReach || ActiveAInteractable != nullptr);
+	SetComponentTickEnabled(bInTransition || (IsLocallyControlled() && bScanActive) || bFocusInteractables);
+
+	const bool bAsyncFocus = bAsyncInteractableFocus && bFocusInteractables;
+
+	if (InteractableScoringTickFunction.IsTickFunctionRegistered())
+	{
+		InteractableScoringTickFunction.SetTickFunctionEnable(bAsyncFocus);
+	}
+
+	if (InteractableFocusTickFunction.IsTickFunctionRegistered())
+	{
+		InteractableFocusTickFunction.SetTickFunctionEnable(bAsyncFocus);
+	}
+}
+
+void USwitchCharacterComponent::UpdateStats() const
+{
+	const int32 numCandidates = CharactersInSight.Num();
+	const int32 numLiveMarkers = MarkerInstances
+		                             ? MarkerInstances->GetInstanceCount()
+		                             : MarkerPool
+		                             ? MarkerPool->GetStats().NumInUse
+		                             : 0;
+
+	INC_DWORD_STAT_BY(STAT_Cameleon_CandidatesInSight, numCandidates);
+	INC_DWORD_STAT_BY(STAT_Cameleon_LiveMarkers, numLiveMarkers);
+
+	CSV_CUSTOM_STAT(Cameleon, CandidatesInSight, numCandidates, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Cameleon, LiveMarkers, numLiveMarkers, ECsvCustomStatOp::Accumulate);
+}
+
+bool USwitchCharacterComponent::IsStageDue(float& TimeSinceLastRun, const float Interval, const float DeltaTime)
+{
+	TimeSinceLastRun += DeltaTime;
+
+	if (TimeSinceLastRun < Interval)
+	{
+		return false;
+	}
+
+	TimeSinceLastRun = Interval > 0.f ? FMath::Fmod(TimeSinceLastRun, Interval) : 0.f;
+	return true;
+}
+
+FControllableCharacterMarkerPoolStats USwitchCharacterComponent::GetMarkerPoolStats() const
+{
+	return MarkerPool ? MarkerPool->GetStats() : FControllableCharacterMarkerPoolStats();
+}
+
+void USwitchCharacterComponent::SetNextAsActive()
+{
+	int32 activeCharacterIndex = CharactersInSight.GetActiveIndex();
+	if (bInTransition || activeCharacterIndex < 0)
+	{
+		return;
+	}
+
+	SetMarkerActive(CharactersInSight[activeCharacterIndex].Character, false);
+
+	if (++activeCharacterIndex >= CharactersInSight.Num())
+	{
+		activeCharacterIndex = 0;
+	}
+
+	CharactersInSight.SetActiveIndex(activeCharacterIndex);
+	SetMarkerActive(CharactersInSight[activeCharacterIndex].Character, true);
+}
+
+void USwitchCharacterComponent::SetPreviousAsActive()
+{
+	int32 activeCharacterIndex = CharactersInSight.GetActiveIndex();
+	if (bInTransition || activeCharacterIndex < 0)
+	{
+		return;
+	}
+
+	SetMarkerActive(CharactersInSight[activeCharacterIndex].Character, false);
+
+	if (--activeCharacterIndex < 0)
+	{
+		activeCharacterIndex = CharactersInSight.Num() - 1;
+	}
+
+	CharactersInSight.SetActiveIndex(activeCharacterIndex);
+	SetMarkerActive(CharactersInSight[activeCharacterIndex].Character, true);
+}
+
+void USwitchCharacterComponent::SwitchCharacter()
+{
+	CAMELEON_PROFILE_SCOPE(SwitchCharacter);
+
+	if (!bCanSwitch || bInTransition || bAwaitingServerSwitch || !CharactersInSight.GetActive())
+	{
+		return;
+	}
+
+	// No traces here, the switch acts on the result of the background validation of the active target
+	// or waits for it if it's too old
+
+	bSwitchRequested = true;
+	SwitchRequestWorldTime = GetWorld()->GetTimeSeconds();
+	SwitchRequestTime = FPlatformTime::Seconds();
+
+	TryStartTransition();
+}
+
+void USwitchCharacterComponent::TryStartTransition()
+{
+	const auto activeCandidate = CharactersInSight.GetActive();
+
+	// Measured in the world time like the validations, so that hitches, pauses and the fixed timestep replays
+	// don't change the outcome
+
+	if (!bCanSwitch || bInTransition || !activeCandidate ||
+		GetWorld()->GetTimeSeconds() - SwitchRequestWorldTime > MaxSwitchValidationAge)
+	{
+		bSwitchRequested = false;
+		return;
+	}
+
+	if (activeCandidate->SwitchValidationTime < 0.f ||
+		GetWorld()->GetTimeSeconds() - activeCandidate->SwitchValidationTime > MaxSwitchValidationAge)
+	{
+		// Validate the active target on the next tick
+		TimeSinceSwitchValidation = SwitchValidationInterval;
+		return;
+	}
+
+	bSwitchRequested = false;
+
+	if (!activeCandidate->bSwitchEligible || !activeCandidate->Camera)
+	{
+		return;
+	}
+
+	// The server has the final say, the transition starts once it replicates back
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		StartTransition(activeCandidate->Character);
+	}
+	else
+	{
+		bAwaitingServerSwitch = true;
+		ServerRequestSwitch(activeCandidate->Character);
+	}
+}
+
+bool USwitchCharacterComponent::IsSwitchAllowedOnServer(const ACameleonGameCharacter* Character) const
+{
+	const auto playerCharacter = PlayerController->GetCharacter();
+
+	// The characters placed in the level are possessed by an AI controller on the server, only the players' ones
+	// are off limits
+	if (!Character || !playerCharacter || Character == playerCharacter || Character->IsPlayerControlled() ||
+		!Character->MatchesScanQuery(ControllableQueryIndex))
+	{
+		return false;
+	}
+
+	// Roughly within the scan volume, which is placed in front of the camera
+
+	const auto toCharacter = Character->GetActorLocation() - playerCharacter->GetActorLocation();
+	const float maxDistance = FVector(ScanDistance.X * 1.5f, ScanDistance.Y, ScanDistance.Z).Size() + ServerValidationMargin;
+
+	if (toCharacter.SizeSquared() > FMath::Square(maxDistance) ||
+		FVector::DotProduct(playerCharacter->GetActorForwardVector(), toCharacter) < 0.f)
+	{
+		return false;
+	}
+
+	// Nothing in the way, the server doesn't know the client's camera so the trace starts at the eyes
+
+	FVector eyesPos;
+	FRotator viewRotation;
+	playerCharacter->GetActorEyesViewPoint(eyesPos, viewRotation);
+
+	FCollisionQueryParams queryParams(SCENE_QUERY_STAT(CameleonServerSwitch), false, playerCharacter);
+
+	FHitResult hitResult;
+	GetWorld()->LineTraceSingleByChannel(hitResult, eyesPos, Character->GetActorLocation(), ECC_Camera, queryParams);
+
+	return hitResult.GetActor() == Character;
+}
+
+bool USwitchCharacterComponent::ServerRequestSwitch_Validate(ACameleonGameCharacter* Character)
+{
+	return true;
+}
+
+void USwitchCharacterComponent::ServerRequestSwitch_Implementation(ACameleonGameCharacter* Character)
+{
+	if (!bCanSwitch || bInTransition || !IsSwitchAllowedOnServer(Character))
+	{
+		ClientRejectSwitch();
+		return;
+	}
+
+	StartTransition(Character);
+}
+
+void USwitchCharacterComponent::ClientRejectSwitch_Implementation()
+{
+	bAwaitingServerSwitch = false;
+}
+
+void USwitchCharacterComponent::StartTransition(ACameleonGameCharacter* Character)
+{
+	PlayerController->UnPossess();
+	PlayerController->SetViewTargetWithBlend(Character, TransitionTimeSeconds);
+
+	TransitionTimer = 0;
+
+	SwitchState.Target = Character;
+	SwitchState.bInTransition = true;
+	MARK_PROPERTY_DIRTY_FROM_NAME(USwitchCharacterComponent, SwitchState, this);
+
+	EnterTransition();
+}
+
+void USwitchCharacterComponent::EnterTransition()
+{
+	const auto character = SwitchState.Target;
+	if (!character)
+	{
+		return;
+	}
+
+	// Prefer the camera cached by the candidate, the replicated target might not be one on this machine
+
+	const auto candidate = CharactersInSight.Find(character);
+	const auto camera = candidate && candidate->Camera
+		                    ? candidate->Camera
+		                    : character->FindComponentByClass<UCameraComponent>();
+
+	if (IsLocallyControlled())
+	{
+		PlayerController->DisableInput(PlayerController);
+
+		// Only the switches requested on this machine are measured
+		if (SwitchRequestTime > 0.0)
+		{
+			const float latencyMs = static_cast<float>((FPlatformTime::Seconds() - SwitchRequestTime) * 1000.0);
+			SET_FLOAT_STAT(STAT_Cameleon_SwitchLatency, latencyMs);
+			CSV_CUSTOM_STAT(Cameleon, SwitchLatencyMs, latencyMs, ECsvCustomStatOp::Set);
+		}
+	}
+
+	bAwaitingServerSwitch = false;
+	bSwitchRequested = false;
+	SwitchRequestTime = 0.0;
+
+	bCanSwitch = false;
+	bInTransition = true;
+	bScanActive = false;
+
+	if (camera)
+	{
+		ScanVolume->AttachToComponent(camera, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+		CurrentCharacterCamera = camera;
+	}
+
+	UpdateTickEnabled();
+}
+
+void USwitchCharacterComponent::ValidateSwitchTargets()
+{
+	const int32 activeCharacterIndex = CharactersInSight.GetActiveIndex();
+	const auto playerCharacter = PlayerController->GetCharacter();
+
+	if (activeCharacterIndex == INDEX_NONE || !playerCharacter || !CurrentCharacterCamera)
+	{
+		return;
+	}
+
+	const int32 numCandidates = CharactersInSight.Num();
+	const auto traceStart = GetVisibilityTraceStart();
+
+	// The active target and the ones we'd cycle to from it
+
+	DispatchSwitchValidation(activeCharacterIndex, traceStart, playerCharacter);
+
+	if (numCandidates > 1)
+	{
+		DispatchSwitchValidation((activeCharacterIndex + 1) % numCandidates, traceStart, playerCharacter);
+	}
+
+	if (numCandidates > 2)
+	{
+		DispatchSwitchValidation((activeCharacterIndex + numCandidates - 1) % numCandidates, traceStart, playerCharacter);
+	}
+}
+
+void USwitchCharacterComponent::DispatchSwitchValidation(const int32 CandidateIndex,
+                                                         const FVector& TraceStart,
+                                                         const ACharacter* PlayerCharacter)
+{
+	auto& candidate = CharactersInSight[CandidateIndex];
+	if (candidate.bSwitchValidationInFlight)
+	{
+		return;
+	}
+
+	// The characters behind us are never eligible, no need to trace for them
+
+	const auto toCharacterDir = (candidate.Character->GetActorLocation() - PlayerCharacter->GetActorLocation()).GetSafeNormal();
+	if (FVector::DotProduct(PlayerCharacter->GetActorForwardVector(), toCharacterDir) < 0.f)
+	{
+		candidate.bSwitchEligible = false;
+		candidate.SwitchValidationTime = GetWorld()->GetTimeSeconds();
+		return;
+	}
+
+	// ... and the rest of them is eligible if nothing is in the way, the last trace is reused
+	// while neither of us moves
+
+	bool bVisible = false;
+	auto visibilitySubsystem = GetWorld()->GetSubsystem<UCameleonVisibilitySubsystem>();
+
+	if (visibilitySubsystem && visibilitySubsystem->FindLineOfSight(CurrentCharacterCamera->GetOwner(),
+	                                                                candidate.Character,
+	                                                                TraceStart,
+	                                                                candidate.Character->GetActorLocation(),
+	                                                                bVisible))
+	{
+		candidate.bSwitchEligible = bVisible;
+		candidate.SwitchValidationTime = GetWorld()->GetTimeSeconds();
+		return;
+	}
+
+	FTraceDelegate traceDelegate = FTraceDelegate::CreateUObject(
+		this, &USwitchCharacterComponent::OnSwitchValidationTraceDone, candidate.Handle, VisibilityCheckEpoch);
+
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single,
+	                                    TraceStart,
+	                                    candidate.Character->GetActorLocation(),
+	                                    ECC_Camera,
+	                                    FCollisionQueryParams::DefaultQueryParam,
+	                                    FCollisionResponseParams::DefaultResponseParam,
+	                                    &traceDelegate);
+
+	candidate.bSwitchValidationInFlight = true;
+
+	INC_DWORD_STAT(STAT_Cameleon_VisibilityTraces);
+	CSV_CUSTOM_STAT(Cameleon, VisibilityTraces, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void USwitchCharacterComponent::OnSwitchValidationTraceDone(const FTraceHandle& TraceHandle,
+                                                            FTraceDatum& TraceData,
+                                                            const FCameleonCandidateHandle Candidate,
+                                                            const int32 Epoch)
+{
+	// The candidate might've left while we were waiting for the result
+
+	const int32 candidateIndex = Epoch == VisibilityCheckEpoch ? CharactersInSight.IndexOf(Candidate) : INDEX_NONE;
+	if (candidateIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	auto& candidate = CharactersInSight[candidateIndex];
+	candidate.bSwitchValidationInFlight = false;
+	candidate.bSwitchEligible = TraceData.OutHits.Num() > 0 && TraceData.OutHits[0].GetActor() == candidate.Character;
+	candidate.SwitchValidationTime = GetWorld()->GetTimeSeconds();
+
+	StoreLineOfSight(candidate.Character, TraceData.Start, TraceData.End, candidate.bSwitchEligible);
+
+	if (bSwitchRequested && candidateIndex == CharactersInSight.GetActiveIndex())
+	{
+		TryStartTransition();
+	}
+}
+
+void USwitchCharacterComponent::UseInteractable()
+{
+	if (ActiveAInteractable)
+	{
+		FInteractableCalls::Interact(ActiveAInteractable);
+
+		if (auto interactableSubsystem = GetWorld()->GetSubsystem<UCameleonInteractableSubsystem>())
+		{
+			interactableSubsystem->NotifyInteractableChanged(ActiveAInteractable);
+		}
+
+		// Focus another one if it can't be used anymore
+		if (!FInteractableCalls::IsUseable(ActiveAInteractable))
+		{
+			SetActiveInteractable(nullptr);
+			bInteractableFocusDirty = true;
+		}
+	}
+}
+
+void USwitchCharacterComponent::ToggleScanAbility()
+{
+	// Don't allow to toggle the ability while in transition
+	if (bInTransition)
+	{
+		return;
+	}
+
+	// Reset the ability if it's currently active
+	if (bScanActive)
+	{
+		bCanSwitch = false;
+		bScanActive = false;
+		//@TODO Remove once we have some nice effect to show the scan region
+		ScanVolume->SetHiddenInGame(true);
+		ClearControllableCharacters();
+	}
+	else
+	{
+		bCanSwitch = true;
+		bScanActive = true;
+		//@TODO Remove once we have some nice effect to show the scan region
+		ScanVolume->SetHiddenInGame(!bDrawScanVolume);
+
+		// Make sure the newly scanned characters are ranked and validated right away
+		TimeSinceScan = ScanInterval;
+		TimeSinceRank = RankInterval;
+		TimeSinceSwitchValidation = SwitchValidationInterval;
+	}
+
+	UpdateTickEnabled();
+}
+
+void USwitchCharacterComponent::UpdateScanVolume()
+{
+	CAMELEON_PROFILE_SCOPE(ScanVolume);
+
+	auto scanSubsystem = GetWorld()->GetSubsystem<UCameleonScanSubsystem>();
+	if (!scanSubsystem || ControllableQueryIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Only the controllable characters are returned, so the ones losing the tag leave the scan volume
+
+	scanSubsystem->QueryScanVolume(ScanVolume->GetComponentTransform(),
+	                               ScanVolume->GetScaledBoxExtent(),
+	                               ScanQueryResults,
+	                               ControllableQueryIndex);
+
+	Swap(CharactersInScanVolume, LastCharactersInScanVolume);
+	CharactersInScanVolume.Reset();
+	CharactersInScanVolume.Append(ScanQueryResults);
+
+	// Notify about the characters that have left the volume since the last update
+
+	for (auto character : LastCharactersInScanVolume)
+	{
+		if (character && !CharactersInScanVolume.Contains(character))
+		{
+			OnCharacterLeftScan(character);
+		}
+	}
+
+	// ... and about the ones that have just entered it
+
+	for (auto character : ScanQueryResults)
+	{
+		if (!LastCharactersInScanVolume.Contains(character))
+		{
+			OnCharacterEnteredScan(character);
+		}
+	}
+}
+
+void USwitchCharacterComponent::OnCharacterEnteredScan(ACameleonGameCharacter* Character)
+{
+	CAMELEON_PROFILE_SCOPE(CharacterEnteredScan);
+
+	// Ignore the scan when changing characters
+
+	if (bInTransition)
+	{
+		return;
+	}
+
+	//sanity check
+
+	if (Character == PlayerController->GetCharacter())
+	{
+		return;
+	}
+
+	if (!Character->MatchesScanQuery(ControllableQueryIndex))
+	{
+		return;
+	}
+
+	// The grid baked for the level answers most of the checks without a trace, a visible character is traced
+	// again by the validation of the switch targets before we switch to it
+
+	if (auto visibilitySubsystem = GetWorld()->GetSubsystem<UCameleonVisibilitySubsystem>())
+	{
+		switch (visibilitySubsystem->QueryVisibility(GetVisibilityTraceStart(), Character->GetActorLocation()))
+		{
+		case ECameleonBakedVisibility::Visible:
+			AddControllableCharacter(Character);
+			return;
+
+		case ECameleonBakedVisibility::Hidden:
+			return;
+
+		default:
+			break;
+		}
+	}
+
+	if (bAsyncVisibilityChecks)
+	{
+		// Queue the visibility check, the character will be added once the result arrives
+		if (!VisibilityChecksInFlight.Contains(Character))
+		{
+			PendingVisibilityChecks.AddUnique(Character);
+		}
+		return;
+	}
+
+	if (CanWeSee(Character))
+	{
+		AddControllableCharacter(Character);
+	}
+}
+
+void USwitchCharacterComponent::AddControllableCharacter(ACameleonGameCharacter* Character)
+{
+	auto mesh = Character->GetMesh();
+	auto capsule = Character->GetCapsuleComponent();
+
+	if (mesh && capsule)
+	{
+		// Calculate the offset from the character's head at which we'll place the marker //
+
+		float radius, halfHeight;
+		capsule->GetScaledCapsuleSize(radius, halfHeight);
+
+		float aboveActorHead = halfHeight + 10;
+
+		// The camera we'd blend to, looked up only once so the switch doesn't have to
+		auto camera = Character->FindComponentByClass<UCameraComponent>();
+		if (!camera)
+		{
+			return;
+		}
+
+		// Get the marker from the pool, the instanced markers are placed in UpdateInstancedMarkers() //
+
+		AControllableCharacterMarker* marker = nullptr;
+		if (MarkerMode == ECameleonMarkerMode::Actors)
+		{
+			marker = MarkerPool->Acquire(Character, {0, 0, aboveActorHead});
+			if (!marker)
+			{
+				return;
+			}
+		}
+
+		// Add the character to the ones in our sight so we can switch if there are multiple,
+		// it's placed according to its score and re-ranked every frame from then on
+
+		const auto handle = CharactersInSight.Add(Character, marker, ScoreCandidate(Character));
+		CharactersInSight[CharactersInSight.IndexOf(handle)].Camera = camera;
+
+		// The character becomes active if it is the only one
+		if (CharactersInSight.GetActiveIndex() == CharactersInSight.IndexOf(handle))
+		{
+			SetMarkerActive(Character, true);
+		}
+		else if (MarkerMode == ECameleonMarkerMode::Instanced)
+		{
+			// The instance of the active character has moved
+			bMarkerHighlightDirty = true;
+		}
+	}
+}
+
+float USwitchCharacterComponent::ScoreCandidate(const ACameleonGameCharacter* Character) const
+{
+	const auto characterLocation = Character->GetActorLocation();
+	float score = 0.f;
+
+	if (CandidateScoring.DistanceWeight != 0.f)
+	{
+		score += CandidateScoring.DistanceWeight * (characterLocation - PlayerController->GetCharacter()->GetActorLocation()).Size();
+	}
+
+	if (CandidateScoring.FacingAngleWeight != 0.f)
+	{
+		const auto toCharacterDir = (characterLocation - CurrentCharacterCamera->GetComponentLocation()).GetSafeNormal();
+		const auto dot = FVector::DotProduct(CurrentCharacterCamera->GetForwardVector(), toCharacterDir);
+		score += CandidateScoring.FacingAngleWeight * FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(dot, -1.f, 1.f)));
+	}
+
+	if (CandidateScoring.ScreenOffsetWeight != 0.f)
+	{
+		int32 viewportWidth, viewportHeight;
+		PlayerController->GetViewportSize(viewportWidth, viewportHeight);
+
+		FVector2D screenLocation;
+		if (PlayerController->ProjectWorldLocationToScreen(characterLocation, screenLocation))
+		{
+			const auto screenCenter = FVector2D(viewportWidth, viewportHeight) * 0.5f;
+			score += CandidateScoring.ScreenOffsetWeight * FVector2D::Distance(screenLocation, screenCenter);
+		}
+		else
+		{
+			// Behind the camera, as far from the center as it gets
+			score += CandidateScoring.ScreenOffsetWeight * FVector2D(viewportWidth, viewportHeight).Size();
+		}
+	}
+
+	return score;
+}
+
+FCameleonScoringView USwitchCharacterComponent::GetScoringView() const
+{
+	FCameleonScoringView view;
+	view.PlayerLocation = PlayerController->GetCharacter()->GetActorLocation();
+	view.CameraLocation = CurrentCharacterCamera->GetComponentLocation();
+	view.CameraForward = CurrentCharacterCamera->GetForwardVector();
+
+	// Same projection as APlayerController::ProjectWorldLocationToScreen() uses
+
+	int32 viewportWidth, viewportHeight;
+	PlayerController->GetViewportSize(viewportWidth, viewportHeight);
+	view.ViewportSize = FVector2D(viewportWidth, viewportHeight);
+
+	const auto localPlayer = Cast<ULocalPlayer>(PlayerController->Player);
+	FSceneViewProjectionData projectionData;
+
+	if (localPlayer && localPlayer->ViewportClient &&
+		localPlayer->GetProjectionData(localPlayer->ViewportClient->Viewport, eSSP_FULL, projectionData))
+	{
+		view.bHasProjection = true;
+		view.ViewProjectionMatrix = projectionData.ComputeViewProjectionMatrix();
+		view.ViewRect = projectionData.GetConstrainedViewRect();
+	}
+
+	return view;
+}
+
+void USwitchCharacterComponent::RankCharactersInSight()
+{
+	CAMELEON_PROFILE_SCOPE(RankCandidates);
+
+	if (CharactersInSight.Num() < 2 || !PlayerController->GetCharacter() || !CurrentCharacterCamera)
+	{
+		return;
+	}
+
+	// Score a snapshot of the candidates off the game thread, only the scores are applied here
+
+	CandidateSnapshot.Reset(CharactersInSight.Num());
+	for (const auto& candidate : CharactersInSight)
+	{
+		CandidateSnapshot.Add(candidate.Character->GetActorLocation(),
+		                      candidate.Character->MatchesScanQuery(ControllableQueryIndex));
+	}
+
+	CandidateSnapshot.Score(GetScoringView(),
+	                        CandidateScoring,
+	                        bParallelCandidateScoring ? MinParallelCandidates : MAX_int32,
+	                        CandidateScores);
+
+	for (int32 candidateIdx = 0; candidateIdx < CharactersInSight.Num(); ++candidateIdx)
+	{
+		CharactersInSight[candidateIdx].Score = CandidateScores[candidateIdx];
+	}
+
+	// The active character stays the same, it only might've moved to a different place in the order
+	if (CharactersInSight.Rank() && MarkerMode == ECameleonMarkerMode::Instanced)
+	{
+		bMarkerHighlightDirty = true;
+	}
+}
+
+void USwitchCharacterComponent::SetMarkerActive(ACameleonGameCharacter* Character, const bool bActive)
+{
+	if (MarkerMode == ECameleonMarkerMode::Instanced)
+	{
+		// The highlight is derived from the active character index when the instances are updated
+		bMarkerHighlightDirty = true;
+		return;
+	}
+
+	const auto candidate = CharactersInSight.Find(Character);
+	if (candidate && candidate->Marker)
+	{
+		candidate->Marker->SetActive(bActive);
+	}
+}
+
+void USwitchCharacterComponent::UpdateInstancedMarkers()
+{
+	const int32 numMarkers = CharactersInSight.Num();
+	int32 numInstances = MarkerInstances->GetInstanceCount();
+
+	if (numMarkers == 0 && numInstances == 0)
+	{
+		return;
+	}
+
+	MarkerInstanceTransforms.Reset(numMarkers);
+	for (const auto& candidate : CharactersInSight)
+	{
+		const auto character = candidate.Character;
+		const float aboveActorHead = character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + 10;
+		MarkerInstanceTransforms.Emplace(FQuat::Identity,
+		                                 character->GetActorLocation() + FVector{0, 0, aboveActorHead},
+		                                 InstancedMarkerScale);
+	}
+
+	// Match the number of instances to the number of characters in sight, instance N always
+	// belongs to the N-th character in sight so only the instances at the end come and go
+
+	if (numInstances != numMarkers)
+	{
+		bMarkerHighlightDirty = true;
+	}
+
+	while (numInstances > numMarkers)
+	{
+		MarkerInstances->RemoveInstance(--numInstances);
+	}
+
+	while (numInstances < numMarkers)
+	{
+		MarkerInstances->AddInstance(MarkerInstanceTransforms[numInstances++]);
+	}
+
+	if (numMarkers > 0)
+	{
+		MarkerInstances->BatchUpdateInstancesTransforms(0, MarkerInstanceTransforms, true, false, true);
+	}
+
+	if (bMarkerHighlightDirty)
+	{
+		const int32 activeCharacterIndex = CharactersInSight.GetActiveIndex();
+		for (int32 markerIdx = 0; markerIdx < numMarkers; ++markerIdx)
+		{
+			MarkerInstances->SetCustomDataValue(markerIdx, 0, markerIdx == activeCharacterIndex ? 1.f : 0.f);
+		}
+
+		bMarkerHighlightDirty = false;
+	}
+
+	MarkerInstances->MarkRenderStateDirty();
+}
+
+void USwitchCharacterComponent::OnCharacterLeftScan(ACameleonGameCharacter* Character)
+{
+	CAMELEON_PROFILE_SCOPE(CharacterLeftScan);
+
+	// Ignore the scan when changing characters
+
+	if (bInTransition)
+	{
+		return;
+	}
+
+	// Sanity check
+	if (Character == PlayerController->GetCharacter())
+	{
+		return;
+	}
+
+	// The result of the trace that might be in flight is discarded when it arrives
+	PendingVisibilityChecks.Remove(Character);
+
+	// Get the marker for the character to return it to the pool
+	if (const auto candidate = CharactersInSight.Find(Character))
+	{
+		const auto marker = candidate->Marker;
+		const bool bWasActive = CharactersInSight.GetActive() == candidate;
+
+		// If the removed character was active, then the next one becomes active
+		CharactersInSight.Remove(Character);
+
+		if (bWasActive)
+		{
+			if (const auto activeCandidate = CharactersInSight.GetActive())
+			{
+				SetMarkerActive(activeCandidate->Character, true);
+			}
+		}
+		else if (MarkerMode == ECameleonMarkerMode::Instanced)
+		{
+			// The instance of the active character might have moved
+			bMarkerHighlightDirty = true;
+		}
+
+		MarkerPool->Release(marker);
+	}
+}
+
+void USwitchCharacterComponent::ClearControllableCharacters()
+{
+	CAMELEON_PROFILE_SCOPE(ClearControllableCharacters);
+
+	// Return all of the markers to the pool
+
+	for (const auto& candidate : CharactersInSight)
+	{
+		MarkerPool->Release(candidate.Marker);
+	}
+
+	CharactersInSight.Empty();
+	CharactersInScanVolume.Empty();
+
+	// The component might stop ticking now, so the instances won't be cleared in UpdateInstancedMarkers()
+	if (MarkerInstances)
+	{
+		MarkerInstances->ClearInstances();
+	}
+
+	PendingVisibilityChecks.Empty();
+	VisibilityChecksInFlight.Empty();
+	++VisibilityCheckEpoch;
+
+	bSwitchRequested = false;
+	bAwaitingServerSwitch = false;
+}
+
+bool USwitchCharacterComponent::CanWeSee(const ACharacter* OtherCharacter) const
+{
+	CAMELEON_PROFILE_SCOPE(CanWeSee);
+
+	const auto traceStart = GetVisibilityTraceStart();
+	const auto traceEnd = OtherCharacter->GetActorLocation();
+
+	bool bVisible = false;
+	auto visibilitySubsystem = GetWorld()->GetSubsystem<UCameleonVisibilitySubsystem>();
+
+	if (visibilitySubsystem && visibilitySubsystem->FindLineOfSight(CurrentCharacterCamera->GetOwner(),
+	                                                                OtherCharacter,
+	                                                                traceStart,
+	                                                                traceEnd,
+	                                                                bVisible))
+	{
+		return bVisible;
+	}
+
+	INC_DWORD_STAT(STAT_Cameleon_VisibilityTraces);
+	CSV_CUSTOM_STAT(Cameleon, VisibilityTraces, 1, ECsvCustomStatOp::Accumulate);
+
+	FHitResult hitResult;
+	GetWorld()->LineTraceSingleByChannel(hitResult, traceStart, traceEnd, ECC_Camera);
+
+	bVisible = OtherCharacter == hitResult.Actor;
+	StoreLineOfSight(OtherCharacter, traceStart, traceEnd, bVisible);
+
+	return bVisible;
+}
+
+void USwitchCharacterComponent::StoreLineOfSight(const AActor* Target,
+                                                 const FVector& TraceStart,
+                                                 const FVector& TraceEnd,
+                                                 const bool bVisible) const
+{
+	auto visibilitySubsystem = GetWorld()->GetSubsystem<UCameleonVisibilitySubsystem>();
+	if (visibilitySubsystem && CurrentCharacterCamera)
+	{
+		visibilitySubsystem->StoreLineOfSight(CurrentCharacterCamera->GetOwner(), Target, TraceStart, TraceEnd, bVisible);
+	}
+}
+
+FVector USwitchCharacterComponent::GetVisibilityTraceStart() const
+{
+	return CurrentCharacterCamera->GetComponentLocation() + CurrentCharacterCamera->GetForwardVector() * 100;
+}
+
+void USwitchCharacterComponent::DispatchVisibilityChecks()
+{
+	if (PendingVisibilityChecks.Num() == 0)
+	{
+		return;
+	}
+
+	const auto traceStart = GetVisibilityTraceStart();
+	const auto viewer = CurrentCharacterCamera->GetOwner();
+	auto visibilitySubsystem = GetWorld()->GetSubsystem<UCameleonVisibilitySubsystem>();
+
+	// The cached results don't count towards the traces started this frame
+
+	int32 numTraces = 0;
+	int32 numChecked = 0;
+
+	for (; numChecked < PendingVisibilityChecks.Num() && numTraces < MaxVisibilityTracesPerFrame; ++numChecked)
+	{
+		auto character = PendingVisibilityChecks[numChecked];
+		if (!character)
+		{
+			continue;
+		}
+
+		bool bVisible = false;
+		if (visibilitySubsystem &&
+			visibilitySubsystem->FindLineOfSight(viewer, character, traceStart, character->GetActorLocation(), bVisible))
+		{
+			OnVisibilityChecked(character, bVisible);
+			continue;
+		}
+
+		FTraceDelegate traceDelegate = FTraceDelegate::CreateUObject(
+			this, &USwitchCharacterComponent::OnVisibilityTraceDone,
+			TWeakObjectPtr<ACameleonGameCharacter>(character), VisibilityCheckEpoch);
+
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single,
+		                                    traceStart,
+		                                    character->GetActorLocation(),
+		                                    ECC_Camera,
+		                                    FCollisionQueryParams::DefaultQueryParam,
+		                                    FCollisionResponseParams::DefaultResponseParam,
+		                                    &traceDelegate);
+
+		VisibilityChecksInFlight.Add(character);
+		++numTraces;
+	}
+
+	PendingVisibilityChecks.RemoveAt(0, numChecked, false);
+
+	INC_DWORD_STAT_BY(STAT_Cameleon_VisibilityTraces, numTraces);
+	CSV_CUSTOM_STAT(Cameleon, VisibilityTraces, numTraces, ECsvCustomStatOp::Accumulate);
+}
+
+void USwitchCharacterComponent::OnVisibilityTraceDone(const FTraceHandle& TraceHandle,
+                                                      FTraceDatum& TraceData,
+                                                      TWeakObjectPtr<ACameleonGameCharacter> Character,
+                                                      int32 Epoch)
+{
+	// Discard the results of the traces started before the characters in sight were cleared
+
+	if (Epoch != VisibilityCheckEpoch || !Character.IsValid())
+	{
+		return;
+	}
+
+	const auto character = Character.Get();
+	VisibilityChecksInFlight.Remove(character);
+
+	const bool bVisible = TraceData.OutHits.Num() > 0 && TraceData.OutHits[0].GetActor() == character;
+	StoreLineOfSight(character, TraceData.Start, TraceData.End, bVisible);
+
+	OnVisibilityChecked(character, bVisible);
+}
+
+void USwitchCharacterComponent::OnVisibilityChecked(ACameleonGameCharacter* Character, const bool bVisible)
+{
+	// The character might've left the scan volume while we were waiting for the result
+
+	if (bInTransition || !bScanActive || !CharactersInScanVolume.Contains(Character) ||
+		CharactersInSight.Contains(Character))
+	{
+		return;
+	}
+
+	if (bVisible)
+	{
+		AddControllableCharacter(Character);
+	}
+}
+
+void FCameleonInteractableScoringTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType,
+                                                          ENamedThreads::Type CurrentThread,
+                                                          const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKillOrUnreachable())
+	{
+		Target->DispatchInteractableFocus();
+	}
+}
+
+FString FCameleonInteractableScoringTickFunction::DiagnosticMessage()
+{
+	return Target->GetFullName() + TEXT("[DispatchInteractableFocus]");
+}
+
+void FCameleonInteractableFocusTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType,
+                                                        ENamedThreads::Type CurrentThread,
+                                                        const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKillOrUnreachable())
+	{
+		Target->ApplyInteractableFocus();
+	}
+}
+
+FString FCameleonInteractableFocusTickFunction::DiagnosticMessage()
+{
+	return Target->GetFullName() + TEXT("[ApplyInteractableFocus]");
+}
@@ -2,7 +2,92 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "GameplayTagContainer.h"
+#include "WorldCollision.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "CameleonCandidateSet.h"
+#include "CameleonInteractableBuffer.h"
+#include "ControllableCharacterMarker.h"
+#include "ControllableCharacterMarkerPool.h"
 #include "SwitchCharacterComponent.generated.h"
+
+// Character the player is switching to, owned by the server //
+USTRUCT()
+struct FCameleonSwitchState
+{
+	GENERATED_BODY()
+
+	// Character we're switching to or have switched to last //
+	UPROPERTY()
+	class ACameleonGameCharacter* Target = nullptr;
+
+	UPROPERTY()
+	bool bInTransition = false;
+};
+
+// Network traffic of the player's connection, measured on the server //
+USTRUCT(BlueprintType)
+struct FCameleonNetStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 InBytesPerSecond = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 OutBytesPerSecond = 0;
+};
+
+// Snapshots the interactables and dispatches their scoring to a worker thread, runs in TG_DuringPhysics //
+USTRUCT()
+struct FCameleonInteractableScoringTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	class USwitchCharacterComponent* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FCameleonInteractableScoringTickFunction> : public TStructOpsTypeTraitsBase2<
+		FCameleonInteractableScoringTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+// Applies the interactable picked on a worker thread during the physics step, runs in TG_PostPhysics //
+USTRUCT()
+struct FCameleonInteractableFocusTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	class USwitchCharacterComponent* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FCameleonInteractableFocusTickFunction> : public TStructOpsTypeTraitsBase2<
+		FCameleonInteractableFocusTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+// Implements the switch ability of a player controller: scanning for the characters we can take control over, //
+// cycling through them, the transition to the picked one and focusing the interactables in front of the player. //
+// The scan, markers and interactables are local to the owning client, the server owns the possession and decides //
+// whether the switch is allowed, the transition state is replicated to the owner //
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class CAMELEONGAME_API USwitchCharacterComponent : public UActorComponent
 {
@@ -12,14 +97,445 @@ public:
 	// Sets default values for this component's properties
 	USwitchCharacterComponent();
 
+	// How the controllable character markers are rendered //
+	UPROPERTY(EditDefaultsOnly)
+	ECameleonMarkerMode MarkerMode = ECameleonMarkerMode::Actors;
+
+	// Actor to spawn as controllable character marker, set by the owning controller //
+	UPROPERTY(Transient)
+	TSubclassOf<class AControllableCharacterMarker> MarkerClass;
+
+	// Number of markers spawned upfront, the pool grows if more of them are needed //
+	UPROPERTY(EditDefaultsOnly)
+	int32 MarkerPoolSize = 16;
+
+	// Mesh used for the markers in the instanced mode //
+	UPROPERTY(EditDefaultsOnly)
+	class UStaticMesh* InstancedMarkerMesh;
+
+	// Material used for the markers in the instanced mode, it should read the highlight from //
+	// the first per-instance custom data float (0 - default, 1 - active) //
+	UPROPERTY(EditDefaultsOnly)
+	class UMaterialInterface* InstancedMarkerMaterial;
+
+	UPROPERTY(EditDefaultsOnly)
+	FVector InstancedMarkerScale = FVector(1.f);
+
+	// Set by the owning controller //
+	UPROPERTY(Transient)
+	float TransitionTimeSeconds = 1.5;
+
+	// How the characters in sight are ranked, they're cycled through in that order //
+	UPROPERTY(EditDefaultsOnly)
+	FCameleonCandidateScoring CandidateScoring;
+
+	// Should the scan volume be drawn while the scan ability is active //
+	UPROPERTY(EditDefaultsOnly)
+	bool bDrawScanVolume = false;
+
+	// Should the visibility of characters entering the scan volume be checked with asynchronous traces, //
+	// the character becomes controllable only once the result of its trace arrives //
+	UPROPERTY(EditDefaultsOnly)
+	bool bAsyncVisibilityChecks = true;
+
+	// Should the re-ranks score the candidates on the worker threads once there are MinParallelCandidates of them //
+	UPROPERTY(EditDefaultsOnly)
+	bool bParallelCandidateScoring = true;
+
+	UPROPERTY(EditDefaultsOnly)
+	int32 MinParallelCandidates = 256;
+
+	// Maximal number of asynchronous visibility traces started in a single frame //
+	UPROPERTY(EditDefaultsOnly)
+	int32 MaxVisibilityTracesPerFrame = 8;
+
+	// Seconds between the scan volume queries, 0 to query every frame //
+	UPROPERTY(EditDefaultsOnly)
+	float ScanInterval = 0.f;
+
+	// Seconds between the re-ranks of the characters in sight, 0 to re-rank every frame //
+	UPROPERTY(EditDefaultsOnly)
+	float RankInterval = 0.1f;
+
+	// Seconds between the background validations of the active switch target and its neighbours //
+	UPROPERTY(EditDefaultsOnly)
+	float SwitchValidationInterval = 0.1f;
+
+	// Age after which the result of the validation is too old to switch on, the switch waits for a fresh one then //
+	UPROPERTY(EditDefaultsOnly)
+	float MaxSwitchValidationAge = 0.25f;
+
+	// Seconds between the updates of the focused interactable, 0 to update every frame //
+	UPROPERTY(EditDefaultsOnly)
+	float InteractableFocusInterval = 1.f / 30.f;
+
+	// Distance from the eyes within which the interactables can be focused //
+	UPROPERTY(EditDefaultsOnly)
+	float InteractableReach = 1000.f;
+
+	// Seconds between the checks whether there are any interactables within the reach, the component //
+	// doesn't tick for the interactables while there are none //
+	UPROPERTY(EditDefaultsOnly)
+	float InteractableProximityInterval = 0.25f;
+
+	// Picks the focused interactable on a worker thread while the physics runs, it's applied in TG_PostPhysics //
+	UPROPERTY(EditDefaultsOnly)
+	bool bAsyncInteractableFocus = true;
+
+	// Extra distance allowed by the server when validating the switch requests, covers the movement in flight //
+	UPROPERTY(EditDefaultsOnly)
+	float ServerValidationMargin = 300.f;
+
+	UFUNCTION(BlueprintPure)
+	FControllableCharacterMarkerPoolStats GetMarkerPoolStats() const;
+
+	// Traffic of the player's connection, only updated on the server //
+	UFUNCTION(BlueprintPure)
+	FCameleonNetStats GetNetStats() const
+	{
+		return NetStats;
+	}
+
+	// Attaches the scan volume to the camera of the possessed character, called whenever the possession changes //
+	void AttachToPossessedCharacter();
+
+	const TSet<class ACameleonGameCharacter*>& GetCharactersInScanVolume() const
+	{
+		return CharactersInScanVolume;
+	}
+
+	// Half extent of the scan volume, which is placed in front of the camera //
+	const FVector& GetScanDistance() const
+	{
+		return ScanDistance;
+	}
+
+	// Character we'd switch to right now or the one we're switching to, if any //
+	class ACameleonGameCharacter* GetActiveCandidateCharacter() const
+	{
+		if (bInTransition)
+		{
+			return SwitchState.Target;
+		}
+
+		const auto activeCandidate = CharactersInSight.GetActive();
+		return activeCandidate ? activeCandidate->Character : nullptr;
+	}
+
+	// Input handling
+
+	UFUNCTION()
+	void SetNextAsActive();
+
+	UFUNCTION()
+	void SetPreviousAsActive();
+
+	UFUNCTION()
+	void SwitchCharacter();
+
+	UFUNCTION()
+	void UseInteractable();
+
+	UFUNCTION()
+	void ToggleScanAbility();
+
 protected:
 
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
 	                           FActorComponentTickFunction* ThisTickFunction) override;
 
+	virtual void RegisterComponentTickFunctions(bool bRegister) override;
+
+	// Starts picking the interactable on a worker thread if the focus update is due, called during the physics //
+	void DispatchInteractableFocus();
+
+	// Waits for the interactable picked on the worker thread and activates it, called after the physics //
+	void ApplyInteractableFocus();
+
+private:
+	// Scan volume handlers
+
+	void OnCharacterEnteredScan(class ACameleonGameCharacter* Character);
+
+	void OnCharacterLeftScan(class ACameleonGameCharacter* Character);
+
+	// Clears the list of characters in sight that we can take control over, removes their markers //
+	void ClearControllableCharacters();
+
+	// Checks if we can see the character, i.e. if it's not blocked by some geometry
+	bool CanWeSee(const ACharacter* OtherCharacter) const;
+
+	// Point from which the visibility traces start //
+	FVector GetVisibilityTraceStart() const;
+
+	// Caches the result of a visibility trace from the current camera //
+	void StoreLineOfSight(const AActor* Target, const FVector& TraceStart, const FVector& TraceEnd, bool bVisible) const;
+
+	// Spawns the marker for a character we can see and adds it to the characters in sight //
+	void AddControllableCharacter(class ACameleonGameCharacter* Character);
+
+	// Computes the score by which the character is ranked among the other characters in sight //
+	float ScoreCandidate(const class ACameleonGameCharacter* Character) const;
+
+	// Gathers the player's view for the scoring of the candidate snapshot //
+	FCameleonScoringView GetScoringView() const;
+
+	// Re-scores the characters in sight and restores their order //
+	void RankCharactersInSight();
+
+	// Highlights the marker of the character or resets it to the default look //
+	void SetMarkerActive(class ACameleonGameCharacter* Character, bool bActive);
+
+	// Moves the marker instances above the characters in sight, one batch for all of them //
+	void UpdateInstancedMarkers();
+
+	// Starts the queued visibility traces, at most MaxVisibilityTracesPerFrame of them //
+	void DispatchVisibilityChecks();
+
+	void OnVisibilityTraceDone(const FTraceHandle& TraceHandle,
+	                           FTraceDatum& TraceData,
+	                           TWeakObjectPtr<class ACameleonGameCharacter> Character,
+	                           int32 Epoch);
+
+	// Adds the character in the scan volume to the characters in sight if we can see it //
+	void OnVisibilityChecked(class ACameleonGameCharacter* Character, bool bVisible);
+
+	// Queries the scan subsystem and notifies about the characters that entered or left the scan volume //
+	void UpdateScanVolume();
+
+	// Validates the active switch target and the ones next to it in the background, so the switch itself //
+	// can act on the results right away //
+	void ValidateSwitchTargets();
+
+	void DispatchSwitchValidation(int32 CandidateIndex, const FVector& TraceStart, const ACharacter* PlayerCharacter);
+
+	void OnSwitchValidationTraceDone(const FTraceHandle& TraceHandle,
+	                                 FTraceDatum& TraceData,
+	                                 FCameleonCandidateHandle Candidate,
+	                                 int32 Epoch);
+
+	// Starts the transition to the active target if it was validated recently and found eligible, //
+	// otherwise the switch request waits for the validation //
+	void TryStartTransition();
+
+	// Checks the switch request of the client, the server can't rely on the client's scan //
+	bool IsSwitchAllowedOnServer(const class ACameleonGameCharacter* Character) const;
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerRequestSwitch(class ACameleonGameCharacter* Character);
+
+	UFUNCTION(Client, Reliable)
+	void ClientRejectSwitch();
+
+	// Unpossesses the current character and starts the blend to the new one, server only //
+	void StartTransition(class ACameleonGameCharacter* Character);
+
+	// Local part of the transition start, runs on the server and on the owning client once the state arrives //
+	void EnterTransition();
+
+	// Local part of the transition end //
+	void FinishTransition();
+
+	UFUNCTION()
+	void OnRep_SwitchState();
+
+	// Advances the transition to the picked character, possesses it once the camera blend is over //
+	void UpdateTransition(float DeltaTime);
+
+	// Records the traffic of the player's connection, server only //
+	void UpdateNetStats();
+
+	// Checks whether there are any interactables within the reach, owning client only //
+	void UpdateInteractablesInReach();
+
+	bool IsLocallyControlled() const;
+
+	// Picks the interactable the player is facing //
+	// Deactivates the current active interactable and activates the given one //
+	void SetActiveInteractable(AActor* aInteractable);
+
+	void UpdateInteractableFocus();
+
+	// The component ticks only while there is something to do: we're in the middle of a transition, or on //
+	// the owning client the scan ability is active or there are interactables within the reach or focused //
+	void UpdateTickEnabled();
+
+	// Adds the component's candidates, markers and interactables to the per-frame counters of the Cameleon stats //
+	void UpdateStats() const;
+
+	// Accumulates the time of a stage and returns true if it's due to run, resets the accumulator then //
+	static bool IsStageDue(float& TimeSinceLastRun, float Interval, float DeltaTime);
+
+	UPROPERTY()
+	class APlayerController* PlayerController;
+
+	// Maximal distance at which we can take control over a character //
+
+	UPROPERTY()
+	FVector ScanDistance = {2500, 1000, 350};
+
+	UPROPERTY()
+	UControllableCharacterMarkerPool* MarkerPool;
+
+	// Renders the markers in the instanced mode //
+
+	UPROPERTY()
+	class UInstancedStaticMeshComponent* MarkerInstances;
+
+	// Scratch buffer for the marker instance transforms //
+
+	TArray<FTransform> MarkerInstanceTransforms;
+
+	// Set when the highlighted marker instance has to be updated //
+
+	bool bMarkerHighlightDirty = false;
+
+	// Box describing the scan volume, it's not colliding with anything and is only used to place //
+	// the volume in front of the camera and to optionally visualize it //
+
+	UPROPERTY()
+	class UBoxComponent* ScanVolume;
+
+	// Flag indicating if the scan ability is currently active //
+
+	UPROPERTY()
+	bool bScanActive;
+
+	// Characters which are currently inside of the scan volume, whether we can control them or not //
+
+	UPROPERTY()
+	TSet<class ACameleonGameCharacter*> CharactersInScanVolume;
+
+	// Scratch buffers for the scan volume updates //
+
+	TArray<class ACameleonGameCharacter*> ScanQueryResults;
+
+	// Scratch buffers for the re-ranks //
+
+	FCameleonCandidateSnapshot CandidateSnapshot;
+
+	TArray<float> CandidateScores;
+
+	TSet<class ACameleonGameCharacter*> LastCharactersInScanVolume;
+
+	// Characters waiting for their asynchronous visibility trace to be started //
+
+	UPROPERTY()
+	TArray<class ACameleonGameCharacter*> PendingVisibilityChecks;
+
+	// Characters whose visibility trace has been started, but the result hasn't arrived yet //
+
+	UPROPERTY()
+	TSet<class ACameleonGameCharacter*> VisibilityChecksInFlight;
+
+	// Incremented whenever the characters in sight are cleared so the results of the traces //
+	// started before that are discarded //
+
+	int32 VisibilityCheckEpoch = 0;
+
+	// Controllable characters in player's sight along with their markers, ordered by their score //
+
+	UPROPERTY()
+	FCameleonCandidateSet CharactersInSight;
+
+	// Flag indicating if we can use the switch ability //
+
+	UPROPERTY()
+	bool bCanSwitch;
+
+	UPROPERTY()
+	bool bInTransition;
+
+	UPROPERTY(ReplicatedUsing = OnRep_SwitchState)
+	FCameleonSwitchState SwitchState;
+
+	// Set while the client waits for the server to accept or reject its switch request //
+	bool bAwaitingServerSwitch = false;
+
+	FCameleonNetStats NetStats;
+
+	FTimerHandle NetStatsTimerHandle;
+
+	FTimerHandle InteractableProximityTimerHandle;
+
+	bool bInteractablesInReach = false;
+
+	// Scratch buffer for the proximity check //
+	TArray<AActor*> InteractablesInReach;
+
+	UPROPERTY()
+	float TransitionTimer;
+
+	// Time since each of the stages has last run //
+
+	float TimeSinceScan = 0.f;
+
+	float TimeSinceRank = 0.f;
+
+	float TimeSinceInteractableFocus = 0.f;
+
+	float TimeSinceSwitchValidation = 0.f;
+
+	// Set when the switch has been requested but the active target hasn't been validated recently enough //
+
+	bool bSwitchRequested = false;
+
+	// World time of the switch request, the request expires after MaxSwitchValidationAge //
+
+	float SwitchRequestWorldTime = 0.f;
+
+	// Platform time of the switch request, used to measure its latency only //
+
+	double SwitchRequestTime = 0.0;
+
+	UPROPERTY()
+	class UCameraComponent* CurrentCharacterCamera;
+
+	// View and interactables for which the active interactable has been picked last time //
+
+	FVector LastFocusEyesPosition = FVector::ZeroVector;
+
+	FVector LastFocusEyeVector = FVector::ZeroVector;
+
+	uint32 LastFocusInteractablesVersion = 0;
+
+	// Forces the next focus update to pick the active interactable again //
+	bool bInteractableFocusDirty = true;
+
+	// Interactables within the reach copied for the worker thread, left alone until the task is done //
+	FCameleonInteractableSnapshot InteractableSnapshot;
+
+	FGraphEventRef InteractableFocusTask;
+
+	// Written by the task, read once it's done //
+	AActor* InteractableFocusResult = nullptr;
+
+	// Set by the component's tick when the focus update is due, the scoring tick picks it up //
+	bool bInteractableFocusDue = false;
+
+	FCameleonInteractableScoringTickFunction InteractableScoringTickFunction;
+
+	FCameleonInteractableFocusTickFunction InteractableFocusTickFunction;
+
+	// Waits for the task picking the interactable, returns false if there was none in flight //
+	bool WaitForInteractableFocusTask();
+
+	UPROPERTY()
+	class AActor* ActiveAInteractable;
+
+	UPROPERTY()
+	FGameplayTagQuery ControllableCharacterQuery;
+
+	// Index under which the query is registered in the scan subsystem //
+
+	int32 ControllableQueryIndex = INDEX_NONE;
 };
@@ -0,0 +1,460 @@
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Async/TaskGraphInterfaces.h"
+#include "Camera/CameraComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+#include "CameleonGameCharacter.h"
+#include "CameleonPlayerController.h"
+#include "CameleonProfiling.h"
+#include "Interactable.h"
+#include "SwitchCharacterComponent.h"
+
+// Headless scaling benchmark of the switch ability, run it with e.g.
+//
+//   UE4Editor-Cmd CameleonGame -nullrhi -unattended -ExecCmds="Automation RunTests Cameleon.Benchmark; Quit"
+//
+// -CameleonBenchCharacters=10,100,1000,5000   numbers of controllable characters to test with
+// -CameleonBenchInteractables=0,100,1000      numbers of interactables to test with
+// -CameleonBenchFrames=600                    length of the camera sweep in frames
+// -CameleonBenchSyncVisibility                check the visibility with CanWeSee() instead of the async traces
+// -CameleonBenchSerialScoring                 score the candidates on the game thread only
+// -CameleonBenchCharacterClass=, -CameleonBenchControllerClass=, -CameleonBenchInteractableClass=
+//                                             classes to spawn instead of the project's blueprints
+//
+// Every combination of the numbers is a separate test writing its report to Saved/Benchmarks/Cameleon
+
+namespace CameleonScalingBenchmark
+{
+	const TCHAR* DefaultCharacterClass = TEXT("/Game/Cameleon/Characters/BaseCharacter.BaseCharacter_C");
+	const TCHAR* DefaultControllerClass =
+		TEXT("/Game/Cameleon/Controllers/Player/BPCameleonPlayerController.BPCameleonPlayerController_C");
+	const TCHAR* DefaultInteractableClass = TEXT("/Game/BPTestInteractable.BPTestInteractable_C");
+	const TCHAR* FloorMesh = TEXT("/Engine/BasicShapes/Cube.Cube");
+
+	const float DeltaTime = 1.f / 60.f;
+
+	// Distance between the neighbouring characters and interactables of the crowd //
+	const float CrowdSpacing = 150.f;
+
+	// The camera sweeps from -SweepYaw to SweepYaw degrees around the player facing the crowd //
+	const float SweepYaw = 90.f;
+
+	TArray<int32> ParseCounts(const TCHAR* Switch, const TArray<int32>& Defaults)
+	{
+		FString value;
+		if (!FParse::Value(FCommandLine::Get(), Switch, value, false))
+		{
+			return Defaults;
+		}
+
+		TArray<FString> parts;
+		value.ParseIntoArray(parts, TEXT(","));
+
+		TArray<int32> counts;
+		for (const auto& part : parts)
+		{
+			counts.Add(FMath::Max(0, FCString::Atoi(*part)));
+		}
+
+		return counts.Num() > 0 ? counts : Defaults;
+	}
+
+	// Returns nullptr if the class can't be loaded, the benchmark would measure something else otherwise //
+	template <typename ClassType>
+	UClass* LoadClassFromCommandLine(const TCHAR* Switch, const TCHAR* DefaultPath, FString& OutPath)
+	{
+		OutPath = DefaultPath;
+		FParse::Value(FCommandLine::Get(), Switch, OutPath);
+
+		return LoadClass<ClassType>(nullptr, *OutPath);
+	}
+
+	// Places the elements of the crowd on a square grid in front of the player, which looks along the X axis //
+	FVector GetCrowdLocation(const int32 Index, const int32 Count, const float Height, const float Offset)
+	{
+		const int32 side = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count))));
+		const int32 row = Index / side;
+		const int32 column = Index % side;
+
+		return {
+			300.f + row * CrowdSpacing + Offset,
+			(column - (side - 1) * 0.5f) * CrowdSpacing + Offset,
+			Height
+		};
+	}
+
+	struct FSummary
+	{
+		double Mean = 0.0;
+		double Median = 0.0;
+		double P95 = 0.0;
+		double Max = 0.0;
+	};
+
+	FSummary Summarize(TArray<double> Samples)
+	{
+		FSummary summary;
+		if (Samples.Num() == 0)
+		{
+			return summary;
+		}
+
+		Samples.Sort();
+
+		double total = 0.0;
+		for (const double sample : Samples)
+		{
+			total += sample;
+		}
+
+		summary.Mean = total / Samples.Num();
+		summary.Median = Samples[Samples.Num() / 2];
+		summary.P95 = Samples[FMath::Min(Samples.Num() - 1, FMath::FloorToInt(Samples.Num() * 0.95f))];
+		summary.Max = Samples.Last();
+		return summary;
+	}
+
+	TSharedRef<FJsonObject> SummaryToJson(const FSummary& Summary)
+	{
+		auto json = MakeShared<FJsonObject>();
+		json->SetNumberField(TEXT("MeanMs"), Summary.Mean);
+		json->SetNumberField(TEXT("MedianMs"), Summary.Median);
+		json->SetNumberField(TEXT("P95Ms"), Summary.P95);
+		json->SetNumberField(TEXT("MaxMs"), Summary.Max);
+		return json;
+	}
+
+	// Per-frame cost of every profiled section and of the whole frame //
+	struct FSamples
+	{
+		TArray<double> Frame;
+
+		TArray<double> Sections[static_cast<uint8>(ECameleonProfileSection::Num)];
+
+		uint32 Calls[static_cast<uint8>(ECameleonProfileSection::Num)] = {};
+
+		void Add(const double FrameMilliseconds, const FCameleonFrameProfile& Profile)
+		{
+			Frame.Add(FrameMilliseconds);
+
+			for (uint8 sectionIdx = 0; sectionIdx < static_cast<uint8>(ECameleonProfileSection::Num); ++sectionIdx)
+			{
+				const auto section = static_cast<ECameleonProfileSection>(sectionIdx);
+				Sections[sectionIdx].Add(Profile.GetMilliseconds(section));
+				Calls[sectionIdx] += Profile.GetCalls(section);
+			}
+		}
+	};
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FCameleonScalingBenchmark, "Cameleon.Benchmark.Scaling",
+                                  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+void FCameleonScalingBenchmark::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	using namespace CameleonScalingBenchmark;
+
+	const auto characterCounts = ParseCounts(TEXT("CameleonBenchCharacters="), {10, 100, 1000, 5000});
+	const auto interactableCounts = ParseCounts(TEXT("CameleonBenchInteractables="), {100});
+
+	for (const int32 numCharacters : characterCounts)
+	{
+		for (const int32 numInteractables : interactableCounts)
+		{
+			OutBeautifiedNames.Add(FString::Printf(TEXT("Characters %d, Interactables %d"),
+			                                       numCharacters, numInteractables));
+			OutTestCommands.Add(FString::Printf(TEXT("%d %d"), numCharacters, numInteractables));
+		}
+	}
+}
+
+bool FCameleonScalingBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace CameleonScalingBenchmark;
+
+	FString charactersParameter, interactablesParameter;
+	if (!Parameters.Split(TEXT(" "), &charactersParameter, &interactablesParameter))
+	{
+		AddError(FString::Printf(TEXT("Invalid benchmark parameters '%s'"), *Parameters));
+		return false;
+	}
+
+	const int32 numCharacters = FCString::Atoi(*charactersParameter);
+	const int32 numInteractables = FCString::Atoi(*interactablesParameter);
+
+	int32 numFrames = 600;
+	FParse::Value(FCommandLine::Get(), TEXT("CameleonBenchFrames="), numFrames);
+	numFrames = FMath::Max(numFrames, 2);
+
+	const bool bSyncVisibility = FParse::Param(FCommandLine::Get(), TEXT("CameleonBenchSyncVisibility"));
+	const bool bSerialScoring = FParse::Param(FCommandLine::Get(), TEXT("CameleonBenchSerialScoring"));
+
+	FString characterPath, controllerPath, interactablePath;
+
+	UClass* characterClass = LoadClassFromCommandLine<ACameleonGameCharacter>(
+		TEXT("CameleonBenchCharacterClass="), DefaultCharacterClass, characterPath);
+	UClass* controllerClass = LoadClassFromCommandLine<ACameleonPlayerController>(
+		TEXT("CameleonBenchControllerClass="), DefaultControllerClass, controllerPath);
+	UClass* interactableClass = LoadClassFromCommandLine<AActor>(
+		TEXT("CameleonBenchInteractableClass="), DefaultInteractableClass, interactablePath);
+
+	if (!characterClass)
+	{
+		AddError(FString::Printf(TEXT("Failed to load the character class %s"), *characterPath));
+	}
+
+	if (!controllerClass)
+	{
+		AddError(FString::Printf(TEXT("Failed to load the player controller class %s"), *controllerPath));
+	}
+
+	// A plain actor in place of the interactables would leave the focus nothing to do
+	const bool bInteractableClassValid = interactableClass &&
+		interactableClass->ImplementsInterface(UInteractable::StaticClass());
+
+	if (!bInteractableClassValid)
+	{
+		AddError(FString::Printf(TEXT("Failed to load the interactable class %s"), *interactablePath));
+	}
+
+	if (!characterClass || !controllerClass || !bInteractableClassValid)
+	{
+		return false;
+	}
+
+	// Generate the test map: a floor with the player at the origin and the crowd in front of it
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CameleonScalingBenchmark"));
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+	world->InitializeActorsForPlay(FURL());
+
+	const float crowdSize = FMath::CeilToFloat(FMath::Sqrt(static_cast<float>(FMath::Max(numCharacters, numInteractables))))
+		* CrowdSpacing + 1000.f;
+
+	if (auto floor = world->SpawnActor<AStaticMeshActor>(FVector(crowdSize * 0.5f, 0.f, -50.f), FRotator::ZeroRotator))
+	{
+		floor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+		floor->GetStaticMeshComponent()->SetStaticMesh(LoadObject<UStaticMesh>(nullptr, FloorMesh));
+		floor->SetActorScale3D({crowdSize / 100.f, crowdSize / 100.f, 1.f});
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const auto controllableTag = FGameplayTag::RequestGameplayTag("Controllable");
+
+	auto player = world->SpawnActor<ACameleonGameCharacter>(characterClass, FVector(0.f, 0.f, 100.f),
+	                                                        FRotator::ZeroRotator, spawnParameters);
+
+	for (int32 characterIdx = 0; characterIdx < numCharacters; ++characterIdx)
+	{
+		auto character = world->SpawnActor<ACameleonGameCharacter>(
+			characterClass, GetCrowdLocation(characterIdx, numCharacters, 100.f, 0.f),
+			FRotator::ZeroRotator, spawnParameters);
+
+		if (character)
+		{
+			character->AddGameplayTag(controllableTag);
+		}
+	}
+
+	// The interactables register with UCameleonInteractableSubsystem as they're spawned
+	for (int32 interactableIdx = 0; interactableIdx < numInteractables; ++interactableIdx)
+	{
+		world->SpawnActor<AActor>(
+			interactableClass, GetCrowdLocation(interactableIdx, numInteractables, 50.f, CrowdSpacing * 0.5f),
+			FRotator::ZeroRotator, spawnParameters);
+	}
+
+	auto controller = world->SpawnActor<ACameleonPlayerController>(controllerClass, FTransform::Identity,
+	                                                               spawnParameters);
+
+	if (!player || !controller)
+	{
+		AddError(TEXT("Failed to spawn the player character or the player controller"));
+		GEngine->DestroyWorldContext(world);
+		world->DestroyWorld(false);
+		return false;
+	}
+
+	auto switchComponent = controller->GetSwitchCharacterComponent();
+	switchComponent->bAsyncVisibilityChecks = !bSyncVisibility;
+	switchComponent->bParallelCandidateScoring = !bSerialScoring;
+
+	// The native controller has no marker class, so the markers can only be instanced
+	if (!controller->MarkerClass)
+	{
+		switchComponent->MarkerMode = ECameleonMarkerMode::Instanced;
+	}
+
+	// The player is possessed before the game starts like in a regular map, the component picks its camera
+	// in BeginPlay(). The camera follows the actor so the sweep doesn't depend on the camera manager
+	controller->Possess(player);
+	player->GetFirstPersonCameraComponent()->bUsePawnControlRotation = false;
+
+	world->BeginPlay();
+	if (!world->HasBegunPlay())
+	{
+		// There's no game mode to start the play
+		world->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	// Sweep the camera through the crowd with the scan ability on
+
+	auto& profile = FCameleonFrameProfile::Get();
+	profile.SetEnabled(true);
+
+	auto tickFrame = [world, &profile](FSamples& Samples)
+	{
+		const uint64 startCycles = FPlatformTime::Cycles64();
+
+		// Ticks the world's tickable objects as well, the subsystems included
+		world->Tick(LEVELTICK_All, DeltaTime);
+
+		Samples.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles), profile);
+		profile.Reset();
+	};
+
+	switchComponent->ToggleScanAbility();
+
+	FSamples sweepSamples;
+	for (int32 frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+	{
+		const float yaw = FMath::Lerp(-SweepYaw, SweepYaw, static_cast<float>(frameIdx) / (numFrames - 1));
+		player->SetActorRotation(FRotator(0.f, yaw, 0.f));
+
+		tickFrame(sweepSamples);
+	}
+
+	// Face the crowd again and switch to whoever is active, then let the transition finish
+
+	player->SetActorRotation(FRotator::ZeroRotator);
+	for (int32 frameIdx = 0; frameIdx < 10; ++frameIdx)
+	{
+		tickFrame(sweepSamples);
+	}
+
+	FSamples switchSamples;
+
+	const uint64 switchStartCycles = FPlatformTime::Cycles64();
+	switchComponent->SwitchCharacter();
+	switchSamples.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - switchStartCycles), profile);
+	profile.Reset();
+
+	const int32 numTransitionFrames = FMath::CeilToInt(switchComponent->TransitionTimeSeconds / DeltaTime) + 2;
+	for (int32 frameIdx = 0; frameIdx < numTransitionFrames; ++frameIdx)
+	{
+		tickFrame(switchSamples);
+	}
+
+	profile.SetEnabled(false);
+
+	const bool bSwitched = controller->GetPawn() && controller->GetPawn() != player;
+
+	// Report
+
+	const FString reportName = FString::Printf(TEXT("Scaling_C%d_I%d%s%s"), numCharacters, numInteractables,
+	                                           bSyncVisibility ? TEXT("_Sync") : TEXT(""),
+	                                           bSerialScoring ? TEXT("_Serial") : TEXT(""));
+	const FString reportDir = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("Cameleon");
+
+	auto report = MakeShared<FJsonObject>();
+	report->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+	report->SetStringField(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+	report->SetStringField(TEXT("BuildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	report->SetNumberField(TEXT("Characters"), numCharacters);
+	report->SetNumberField(TEXT("Interactables"), numInteractables);
+	report->SetNumberField(TEXT("Frames"), numFrames);
+	report->SetNumberField(TEXT("DeltaTime"), DeltaTime);
+	report->SetBoolField(TEXT("SyncVisibility"), bSyncVisibility);
+	report->SetBoolField(TEXT("ParallelScoring"), !bSerialScoring);
+	report->SetNumberField(TEXT("WorkerThreads"), FTaskGraphInterface::Get().GetNumWorkerThreads());
+	report->SetBoolField(TEXT("Switched"), bSwitched);
+	report->SetNumberField(TEXT("SwitchMs"), switchSamples.Sections[static_cast<uint8>(
+		                       ECameleonProfileSection::SwitchCharacter)][0]);
+	report->SetObjectField(TEXT("Frame"), SummaryToJson(Summarize(sweepSamples.Frame)));
+	report->SetObjectField(TEXT("TransitionFrame"), SummaryToJson(Summarize(switchSamples.Frame)));
+
+	auto sections = MakeShared<FJsonObject>();
+	for (uint8 sectionIdx = 0; sectionIdx < static_cast<uint8>(ECameleonProfileSection::Num); ++sectionIdx)
+	{
+		auto section = SummaryToJson(Summarize(sweepSamples.Sections[sectionIdx]));
+		section->SetNumberField(TEXT("Calls"), sweepSamples.Calls[sectionIdx]);
+		sections->SetObjectField(FCameleonFrameProfile::GetSectionName(static_cast<ECameleonProfileSection>(sectionIdx)),
+		                         section);
+	}
+	report->SetObjectField(TEXT("Sections"), sections);
+
+	FString json;
+	FJsonSerializer::Serialize(report, TJsonWriterFactory<>::Create(&json));
+	FFileHelper::SaveStringToFile(json, *(reportDir / reportName + TEXT(".json")));
+
+	// One row per frame, the switch itself and the transition frames follow the sweep
+
+	FString csv = TEXT("Phase,Frame,FrameMs");
+	for (uint8 sectionIdx = 0; sectionIdx < static_cast<uint8>(ECameleonProfileSection::Num); ++sectionIdx)
+	{
+		csv += FString::Printf(TEXT(",%sMs"),
+		                       FCameleonFrameProfile::GetSectionName(static_cast<ECameleonProfileSection>(sectionIdx)));
+	}
+	csv += LINE_TERMINATOR;
+
+	auto appendRows = [&csv](const TCHAR* Phase, const FSamples& Samples)
+	{
+		for (int32 frameIdx = 0; frameIdx < Samples.Frame.Num(); ++frameIdx)
+		{
+			csv += FString::Printf(TEXT("%s,%d,%.4f"), Phase, frameIdx, Samples.Frame[frameIdx]);
+			for (const auto& section : Samples.Sections)
+			{
+				csv += FString::Printf(TEXT(",%.4f"), section[frameIdx]);
+			}
+			csv += LINE_TERMINATOR;
+		}
+	};
+
+	appendRows(TEXT("Sweep"), sweepSamples);
+	appendRows(TEXT("Switch"), switchSamples);
+
+	FFileHelper::SaveStringToFile(csv, *(reportDir / reportName + TEXT(".csv")));
+
+	const auto frameSummary = Summarize(sweepSamples.Frame);
+	AddInfo(FString::Printf(TEXT("%d characters, %d interactables: frame mean %.3f ms, p95 %.3f ms, max %.3f ms%s"),
+	                        numCharacters, numInteractables, frameSummary.Mean, frameSummary.P95, frameSummary.Max,
+	                        bSwitched ? TEXT("") : TEXT(", no switch")));
+
+	// A broken switch pipeline mustn't pass as a fast one
+
+	if (numCharacters > 0 && !bSwitched)
+	{
+		AddError(TEXT("The switch to a character of the crowd didn't complete"));
+	}
+
+	// Tear the test map down
+
+	world->BeginTearingDown();
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return numCharacters == 0 || bSwitched;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS